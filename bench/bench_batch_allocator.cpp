@@ -0,0 +1,56 @@
+#include "bitmap_allocator.h"
+#include "concurrent_allocator.h"
+#include "typed_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "memory"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int pool_size = 4096;
+constexpr int objects = 1 << 24;
+
+// Per-object cost of moving `objects` objects through the pool in
+// batches of `batch`, against the same traffic one call at a time.
+template<class Pool>
+void bench(const char *name, int batch) {
+    auto pool = make_unique<Pool>();
+    auto ptrs = make_unique<long *[]>(batch);
+
+    auto start = chrono::steady_clock::now();
+    for(int done = 0; done < objects; done += batch) {
+        pool->allocate_n(ptrs.get(), batch);
+        pool->deallocate_n(ptrs.get(), batch);
+    }
+    auto mid = chrono::steady_clock::now();
+    for(int done = 0; done < objects; done += batch) {
+        for(int i = 0; i < batch; ++i) {
+            ptrs[i] = pool->allocate();
+        }
+        for(int i = 0; i < batch; ++i) {
+            pool->deallocate(ptrs[i]);
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+
+    double batched = chrono::duration<double, nano>(mid - start).count() / objects;
+    double single = chrono::duration<double, nano>(stop - mid).count() / objects;
+    cout << name << "\tbatch=" << batch
+        << "\tbatched=" << batched << " ns/obj"
+        << "\tsingle=" << single << " ns/obj" << endl;
+}
+
+template<class Pool>
+void bench_all(const char *name) {
+    for(int batch : {1, 8, 64, 512}) {
+        bench<Pool>(name, batch);
+    }
+}
+
+int main() {
+    bench_all<typed_allocator<long, pool_size>>("typed_allocator");
+    bench_all<bitmap_allocator<long, pool_size>>("bitmap_allocator");
+    bench_all<concurrent_allocator<long, pool_size>>("concurrent_allocator");
+    return 0;
+}
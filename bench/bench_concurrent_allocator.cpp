@@ -0,0 +1,86 @@
+#include "concurrent_allocator.h"
+#include "magazine_allocator.h"
+#include "typed_allocator.h"
+#include "atomic"
+#include "chrono"
+#include "iostream"
+#include "memory"
+#include "mutex"
+#include "thread"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int pool_size = 4096;
+constexpr int ops_per_thread = 1 << 20;
+
+// Lets a shared pool be used directly by run().
+template<class Shared>
+struct direct {
+    Shared &shared;
+    explicit direct(Shared &shared) : shared(shared) {}
+    auto allocate() -> long* { return shared.allocate(); }
+    auto deallocate(long *p) -> int { return shared.deallocate(p); }
+};
+
+// typed_allocator behind a mutex, the way callers share it today.
+struct locked_pool {
+    typed_allocator<long, pool_size> pool;
+    mutex lock;
+
+    auto allocate() -> long* {
+        lock_guard<mutex> guard(lock);
+        return pool.allocate();
+    }
+    auto deallocate(long *p) -> int {
+        lock_guard<mutex> guard(lock);
+        return pool.deallocate(p);
+    }
+};
+
+// Pool is what the workers call into; Shared is what they are built from,
+// which lets each worker put its own magazine in front of a shared pool.
+template<class Pool, class Shared>
+double run(Shared &shared, int threads) {
+    atomic<bool> go(false);
+    vector<thread> workers;
+    for(int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            Pool pool(shared);
+            while(!go.load()) {
+            }
+            for(int i = 0; i < ops_per_thread; ++i) {
+                long *p = pool.allocate();
+                if(p != nullptr) {
+                    pool.deallocate(p);
+                }
+            }
+        });
+    }
+    auto start = chrono::steady_clock::now();
+    go.store(true);
+    for(auto &w : workers) {
+        w.join();
+    }
+    auto stop = chrono::steady_clock::now();
+    double s = chrono::duration<double>(stop - start).count();
+    return 2.0 * ops_per_thread * threads / s / 1e6;
+}
+
+int main() {
+    using lock_free_pool = concurrent_allocator<long, pool_size>;
+
+    auto lock_free = make_unique<lock_free_pool>();
+    auto locked = make_unique<locked_pool>();
+
+    cout << "threads\tconcurrent_allocator Mops/s\tmagazine+concurrent Mops/s"
+        "\tmutex+typed_allocator Mops/s" << endl;
+    for(int threads = 1; threads <= 64; threads *= 2) {
+        double a = run<direct<lock_free_pool>>(*lock_free, threads);
+        double b = run<magazine_allocator<lock_free_pool, 32>>(*lock_free, threads);
+        double c = run<direct<locked_pool>>(*locked, threads);
+        cout << threads << "\t" << a << "\t" << b << "\t" << c << endl;
+    }
+    return 0;
+}
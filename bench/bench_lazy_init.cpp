@@ -0,0 +1,58 @@
+#include "typed_allocator.h"
+#include "chrono"
+#include "cstdio"
+#include "cstdlib"
+#include "new"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+struct record {
+    long payload[16];
+};
+
+// 128 MiB of slots, of which only a few are ever used.
+constexpr int slots = 1 << 20;
+constexpr int used = 1000;
+
+auto resident_kb() -> long {
+    long size = 0, resident = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if(f != nullptr) {
+        if(fscanf(f, "%ld %ld", &size, &resident) != 2) {
+            resident = 0;
+        }
+        fclose(f);
+    }
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// calloc gives fresh zero pages for a block this large, which is what a
+// lazy_init pool requires and what .bss provides for a static pool.
+template<class Init>
+void bench(const char *name) {
+    using pool_type = typed_allocator<record, slots, Init>;
+    long before = resident_kb();
+    void *raw = calloc(1, sizeof(pool_type));
+
+    auto start = chrono::steady_clock::now();
+    auto pool = new (raw) pool_type;
+    auto constructed = chrono::steady_clock::now();
+    for(int i = 0; i < used; ++i) {
+        pool->allocate()->payload[0] = i;
+    }
+    long after = resident_kb();
+
+    double us = chrono::duration<double, micro>(constructed - start).count();
+    printf("%s\tconstruct=%.1f us\trss_growth=%ld KiB\tpool=%zu KiB\n",
+        name, us, after - before, sizeof(pool_type) / 1024);
+    pool->~pool_type();
+    free(raw);
+}
+
+int main() {
+    bench<lazy_init>("lazy_init");
+    bench<eager_init>("eager_init");
+    return 0;
+}
@@ -0,0 +1,54 @@
+#include "mapped_allocator.h"
+#include "chrono"
+#include "cstdlib"
+#include "iostream"
+#include "memory"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+struct entry {
+    long key;
+    char payload[120];
+};
+
+constexpr int entries = 50000;
+using pool_type = mapped_allocator<entry, entries>;
+
+auto ms_since(chrono::steady_clock::time_point start) -> double {
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+// Time to bring a full cache back: reattaching the mapped file against
+// filling a fresh pool again.
+int main() {
+    char path[] = "/tmp/bench_mapped_allocatorXXXXXX";
+    int fd = mkstemp(path);
+    if(fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    auto start = chrono::steady_clock::now();
+    {
+        auto pool = make_unique<pool_type>(path);
+        for(int i = 0; i < entries; ++i) {
+            pool->allocate()->key = i;
+        }
+    }
+    cout << "build+close\t" << ms_since(start) << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    long keys = 0;
+    {
+        auto pool = make_unique<pool_type>(path);
+        pool->for_each([&keys](entry *e) {
+            keys += e->key;
+        });
+        cout << "reattach\t" << ms_since(start) << " ms\tattached=" << pool->attached()
+            << "\t" << (keys == long(entries) * (entries - 1) / 2) << endl;
+    }
+    unlink(path);
+    return 0;
+}
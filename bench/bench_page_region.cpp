@@ -0,0 +1,54 @@
+#include "page_region.h"
+#include "chrono"
+#include "cstdint"
+#include "iostream"
+
+using namespace std;
+using namespace kcore;
+
+constexpr size_t region_bytes = size_t(256) << 20;
+constexpr long steps = 1 << 24;
+
+// Chases a random cycle through every 4 KiB page of the region, so on
+// base pages nearly every hop misses the TLB.
+void bench(page_backing prefer) {
+    auto start = chrono::steady_clock::now();
+    page_region region(region_bytes, true, prefer);
+    double map_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if(region.backing() == page_backing::none) {
+        cout << backing_name(prefer) << "\tunavailable" << endl;
+        return;
+    }
+
+    auto cells = static_cast<size_t *>(region.data());
+    size_t count = region.size() / 4096;
+    size_t stride = 4096 / sizeof(size_t);
+    // Sattolo's shuffle: next-page indices forming a single cycle
+    uint64_t rng = 88172645463325252ULL;
+    for(size_t i = 0; i < count; ++i) {
+        cells[i * stride] = i;
+    }
+    for(size_t i = count - 1; i > 0; --i) {
+        rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+        size_t j = rng % i;
+        size_t t = cells[i * stride];
+        cells[i * stride] = cells[j * stride];
+        cells[j * stride] = t;
+    }
+    size_t at = 0;
+    start = chrono::steady_clock::now();
+    for(long s = 0; s < steps; ++s) {
+        at = cells[at * stride];
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / steps;
+    cout << "want=" << backing_name(prefer) << "\tgot=" << backing_name(region.backing())
+        << "\thuge=" << (region.huge_bytes() >> 20) << " MiB\tmap+prefault=" << map_ms
+        << " ms\t" << ns << " ns/hop\t(" << at << ")" << endl;
+}
+
+int main() {
+    bench(page_backing::hugetlb);
+    bench(page_backing::transparent);
+    bench(page_backing::normal);
+    return 0;
+}
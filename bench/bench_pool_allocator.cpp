@@ -0,0 +1,79 @@
+#include "pool_allocator.h"
+#include "tlsf_allocator.h"
+#include "typed_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "list"
+#include "memory"
+#include "unordered_map"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int rounds = 2000;
+constexpr int items = 1000;
+
+struct alignas(16) node_slot {
+    unsigned char data[32];
+};
+
+template<class F>
+void time(const char *name, F body) {
+    auto start = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        body();
+    }
+    auto stop = chrono::steady_clock::now();
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    cout << name << "\t" << ns / (double(rounds) * items) << " ns/item" << endl;
+}
+
+int main() {
+    constexpr size_t region_size = 4 << 20;
+    auto region = make_unique<unsigned char[]>(region_size);
+    tlsf_allocator<char> heap(region.get(), region_size);
+    auto nodes = make_unique<typed_allocator<node_slot, items>>();
+
+    using heap_alloc = pool_allocator<int, tlsf_allocator<char>>;
+    using node_alloc = pool_allocator<int, typed_allocator<node_slot, items>>;
+    using map_alloc = pool_allocator<pair<const int, int>, tlsf_allocator<char>>;
+
+    time("vector/std::allocator", [] {
+        vector<int> v;
+        for(int i = 0; i < items; ++i) {
+            v.push_back(i);
+        }
+    });
+    time("vector/tlsf", [&] {
+        vector<int, heap_alloc> v{heap_alloc(heap)};
+        for(int i = 0; i < items; ++i) {
+            v.push_back(i);
+        }
+    });
+    time("list/std::allocator", [] {
+        list<int> l;
+        for(int i = 0; i < items; ++i) {
+            l.push_back(i);
+        }
+    });
+    time("list/typed_allocator", [&] {
+        list<int, node_alloc> l{node_alloc(*nodes)};
+        for(int i = 0; i < items; ++i) {
+            l.push_back(i);
+        }
+    });
+    time("unordered_map/std::allocator", [] {
+        unordered_map<int, int> m;
+        for(int i = 0; i < items; ++i) {
+            m[i] = i;
+        }
+    });
+    time("unordered_map/tlsf", [&] {
+        unordered_map<int, int, hash<int>, equal_to<int>, map_alloc> m{map_alloc(heap)};
+        for(int i = 0; i < items; ++i) {
+            m[i] = i;
+        }
+    });
+    return 0;
+}
@@ -0,0 +1,61 @@
+#include "pool_map.h"
+#include "typed_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "memory"
+#include "random"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int pools = 48;
+constexpr int slots = 64;
+constexpr int rounds = 2000;
+
+using pool_type = registered<typed_allocator<long, slots>>;
+
+// Freeing a void * whose pool is unknown: asking every pool in turn
+// against one pool_map lookup.
+int main() {
+    vector<unique_ptr<pool_type>> all;
+    vector<void *> ptrs;
+    for(int i = 0; i < pools; ++i) {
+        all.push_back(make_unique<pool_type>());
+    }
+    mt19937 rng(1);
+    for(int i = 0; i < pools * slots; ++i) {
+        ptrs.push_back(all[rng() % pools]->allocate());
+    }
+    for(size_t i = 0; i < ptrs.size(); ++i) {
+        if(ptrs[i] == nullptr) {
+            ptrs[i] = ptrs[0];
+        }
+    }
+
+    size_t found = 0;
+    auto start = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        for(void *p : ptrs) {
+            for(auto &pool : all) {
+                if(pool->has(static_cast<long *>(p))) {
+                    ++found;
+                    break;
+                }
+            }
+        }
+    }
+    auto mid = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        for(void *p : ptrs) {
+            found += pool_map::find(p) != nullptr;
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+
+    double n = double(rounds) * ptrs.size();
+    cout << "linear has()\t" << chrono::duration<double, nano>(mid - start).count() / n << " ns/lookup" << endl;
+    cout << "pool_map\t" << chrono::duration<double, nano>(stop - mid).count() / n << " ns/lookup"
+        << "\t(" << found << ")" << endl;
+    return 0;
+}
@@ -0,0 +1,60 @@
+#include "pool_ptr.h"
+#include "typed_allocator.h"
+#include "concurrent_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "memory"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int rounds = 2000;
+constexpr int items = 256;
+constexpr int consumers = 4;
+
+struct frame {
+    long stamp;
+    float samples[14];
+    frame(long stamp) : stamp(stamp) {}
+};
+
+static typed_allocator<frame, items> frames;
+static concurrent_allocator<frame, items> shared_frames;
+
+// Produce a batch of frames, hand each to a few consumers, then drop all.
+template<class Make>
+void time(const char *name, Make make) {
+    using handle = decltype(make(0L));
+    static handle batch[items][consumers];
+    long sum = 0;
+    auto start = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        for(int i = 0; i < items; ++i) {
+            batch[i][0] = make(long(i));
+            for(int c = 1; c < consumers; ++c) {
+                batch[i][c] = batch[i][0];
+            }
+            sum += batch[i][consumers - 1]->stamp;
+        }
+        for(int i = 0; i < items; ++i) {
+            for(int c = 0; c < consumers; ++c) {
+                batch[i][c] = nullptr;
+            }
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    cout << name << "\t" << ns / (double(rounds) * items) << " ns/frame\t"
+        << sizeof(handle) << " B/handle\t" << (sum != 0) << endl;
+}
+
+int main() {
+    time("std::make_shared", [](long t) { return make_shared<frame>(t); });
+    time("make_shared_pooled/typed", [](long t) {
+        return make_shared_pooled<frame, frames>(t);
+    });
+    time("make_shared_pooled/concurrent", [](long t) {
+        return make_shared_pooled<frame, shared_frames>(t);
+    });
+    return 0;
+}
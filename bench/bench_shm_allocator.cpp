@@ -0,0 +1,117 @@
+#include "shm_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "sys/mman.h"
+#include "sys/socket.h"
+#include "sys/wait.h"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+struct sample {
+    long seq;
+    unsigned char data[4096 - sizeof(long)];
+};
+
+constexpr int slots = 256;
+constexpr long handoffs = 100000;
+
+using pool_type = shm_allocator<sample, slots>;
+
+static auto read_all(int fd, void *buf, size_t bytes) -> bool {
+    auto p = static_cast<unsigned char *>(buf);
+    while(bytes > 0) {
+        ssize_t got = read(fd, p, bytes);
+        if(got <= 0) {
+            return false;
+        }
+        p += got;
+        bytes -= size_t(got);
+    }
+    return true;
+}
+
+static auto write_all(int fd, const void *buf, size_t bytes) -> bool {
+    auto p = static_cast<const unsigned char *>(buf);
+    while(bytes > 0) {
+        ssize_t put = write(fd, p, bytes);
+        if(put <= 0) {
+            return false;
+        }
+        p += put;
+        bytes -= size_t(put);
+    }
+    return true;
+}
+
+template<class Producer, class Consumer>
+void bench(const char *name, Producer produce, Consumer consume) {
+    int fds[2];
+    if(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        return;
+    }
+    auto start = chrono::steady_clock::now();
+    pid_t child = fork();
+    if(child == 0) {
+        close(fds[0]);
+        _exit(consume(fds[1]) ? 0 : 1);
+    }
+    close(fds[1]);
+    produce(fds[0]);
+    close(fds[0]);
+    int status;
+    waitpid(child, &status, 0);
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << "\t" << handoffs / s / 1e3 << " k samples/s\t"
+        << handoffs * sizeof(sample) / s / (1 << 20) << " MiB/s"
+        << (WIFEXITED(status) && WEXITSTATUS(status) == 0 ? "" : "\tFAILED") << endl;
+}
+
+// One producer process hands 4 KiB samples to a consumer process, either
+// copying each through a Unix socket or passing only its shm offset.
+int main() {
+    bench("socket copy", [](int fd) {
+        sample s;
+        for(long seq = 0; seq < handoffs; ++seq) {
+            s.seq = seq;
+            s.data[seq % sizeof(s.data)] = (unsigned char)seq;
+            write_all(fd, &s, sizeof(s));
+        }
+    }, [](int fd) {
+        sample s;
+        for(long seq = 0; seq < handoffs; ++seq) {
+            if(!read_all(fd, &s, sizeof(s)) || s.seq != seq) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    int shm = memfd_create("bench_shm_allocator", 0);
+    bench("shm offset", [shm](int fd) {
+        pool_type pool(shm);
+        for(long seq = 0; seq < handoffs; ++seq) {
+            sample *s;
+            while((s = pool.allocate()) == nullptr) {
+                sched_yield();
+            }
+            s->seq = seq;
+            s->data[seq % sizeof(s->data)] = (unsigned char)seq;
+            uint64_t offset = pool.offset_of(s);
+            write_all(fd, &offset, sizeof(offset));
+        }
+    }, [shm](int fd) {
+        pool_type pool(shm);
+        uint64_t offset;
+        for(long seq = 0; seq < handoffs; ++seq) {
+            if(!read_all(fd, &offset, sizeof(offset)) || pool.at(offset)->seq != seq) {
+                return false;
+            }
+            pool.deallocate(pool.at(offset));
+        }
+        return true;
+    });
+    close(shm);
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include "typed_allocator.h"
+#include "atomic"
+#include "chrono"
+#include "iostream"
+#include "memory"
+#include "thread"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int writes_per_thread = 1 << 24;
+
+struct counter {
+    long value;
+};
+
+// Each thread takes one slot from a shared pool and keeps updating its
+// own object; with packed slots the objects share cache lines.
+template<class Layout>
+void bench(const char *name, int threads) {
+    auto pool = make_unique<typed_allocator<counter, 64, eager_init, Layout>>();
+    vector<counter *> mine;
+    for(int t = 0; t < threads; ++t) {
+        mine.push_back(pool->allocate());
+    }
+    atomic<bool> go(false);
+    vector<thread> workers;
+    for(int t = 0; t < threads; ++t) {
+        workers.emplace_back([&go, c = mine[t]] {
+            while(!go.load()) {
+            }
+            auto *v = reinterpret_cast<volatile long *>(&c->value);
+            for(int i = 0; i < writes_per_thread; ++i) {
+                *v = *v + 1;
+            }
+        });
+    }
+    auto start = chrono::steady_clock::now();
+    go.store(true);
+    for(auto &w : workers) {
+        w.join();
+    }
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << "\tthreads=" << threads << "\t"
+        << double(writes_per_thread) * threads / s / 1e6 << " Mwrites/s\tslot="
+        << reinterpret_cast<char *>(mine[1]) - reinterpret_cast<char *>(mine[0]) << " B" << endl;
+}
+
+int main() {
+    int threads = int(thread::hardware_concurrency());
+    threads = threads < 2 ? 2 : threads > 8 ? 8 : threads;
+    bench<packed_layout>("packed", threads);
+    bench<padded_layout>("padded", threads);
+    bench<split_layout>("split", threads);
+    return 0;
+}
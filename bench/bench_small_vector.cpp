@@ -0,0 +1,68 @@
+#include "small_vector.h"
+#include "static_vector.h"
+#include "tlsf_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "memory"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int rounds = 1 << 18;
+constexpr int items = 12;
+
+template<class F>
+void time(const char *container, const char *op, F body) {
+    long sink = 0;
+    auto start = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        sink += body();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    cout << container << "\t" << op << "\t" << ns / rounds << " ns/round\t(" << (sink != 0) << ")" << endl;
+}
+
+// Each round builds a short vector from scratch, as per-request code does:
+// push_back, insert at the front, or erase from the front.
+template<class Make>
+void bench(const char *container, Make make) {
+    time(container, "push", [&] {
+        auto v = make();
+        for(int i = 0; i < items; ++i) {
+            v.push_back(i);
+        }
+        return long(v.back());
+    });
+    time(container, "insert", [&] {
+        auto v = make();
+        for(int i = 0; i < items; ++i) {
+            v.insert(v.begin(), i);
+        }
+        return long(v.front());
+    });
+    time(container, "erase", [&] {
+        auto v = make();
+        for(int i = 0; i < items; ++i) {
+            v.push_back(i);
+        }
+        long sum = 0;
+        while(!v.empty()) {
+            sum += v.front();
+            v.erase(v.begin());
+        }
+        return sum;
+    });
+}
+
+int main() {
+    constexpr size_t region_size = 1 << 20;
+    auto region = make_unique<unsigned char[]>(region_size);
+    tlsf_allocator<char> heap(region.get(), region_size);
+
+    bench("std::vector", [] { return vector<int>(); });
+    bench("static_vector<16>", [] { return static_vector<int, 16>(); });
+    bench("small_vector<16>", [&] { return small_vector<int, 16, decltype(heap)>(heap); });
+    bench("small_vector<4>+tlsf", [&] { return small_vector<int, 4, decltype(heap)>(heap); });
+    return 0;
+}
@@ -0,0 +1,156 @@
+#include "spsc_ring.h"
+#include "chrono"
+#include "condition_variable"
+#include "deque"
+#include "iostream"
+#include "mutex"
+#include "thread"
+
+using namespace std;
+using namespace kcore;
+
+// What the ingest thread hands over: a sequence number and a little
+// payload, 64 bytes in all.
+struct frame {
+    long seq;
+    long payload[7];
+};
+
+constexpr long items = 1 << 22;
+constexpr size_t slots = 1024;
+constexpr size_t batch = 32;
+
+// Runs produce and consume on two threads and reports items/s; consume
+// returns false if frames arrive out of order.
+template<class Producer, class Consumer>
+void bench(const char *name, Producer produce, Consumer consume) {
+    auto start = chrono::steady_clock::now();
+    thread producer(produce);
+    bool ok = consume();
+    producer.join();
+    double s = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << name << "\t" << items / s / 1e6 << " M items/s\t"
+        << s * 1e9 / items << " ns/item" << (ok ? "" : "\tFAILED") << endl;
+}
+
+static auto fill(frame &f, long seq) -> void {
+    f.seq = seq;
+    f.payload[seq % 7] = seq;
+}
+
+int main() {
+    {
+        mutex lock;
+        condition_variable ready;
+        deque<frame> queue;
+        bench("mutex+deque", [&] {
+            frame f;
+            for(long seq = 0; seq < items; ++seq) {
+                fill(f, seq);
+                {
+                    lock_guard<mutex> g(lock);
+                    queue.push_back(f);
+                }
+                ready.notify_one();
+            }
+        }, [&] {
+            for(long seq = 0; seq < items; ++seq) {
+                unique_lock<mutex> g(lock);
+                ready.wait(g, [&] { return !queue.empty(); });
+                frame f = queue.front();
+                queue.pop_front();
+                if(f.seq != seq) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    }
+
+    static spsc_ring<frame, slots> ring;
+    bench("spsc push/pop", [] {
+        frame f;
+        for(long seq = 0; seq < items; ++seq) {
+            fill(f, seq);
+            while(!ring.push(f)) {
+                this_thread::yield();
+            }
+        }
+    }, [] {
+        frame f;
+        for(long seq = 0; seq < items; ++seq) {
+            while(!ring.pop(f)) {
+                this_thread::yield();
+            }
+            if(f.seq != seq) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    bench("spsc push_n/pop_n", [] {
+        frame f[batch];
+        for(long seq = 0; seq < items; ) {
+            for(size_t i = 0; i < batch; ++i) {
+                fill(f[i], seq + long(i));
+            }
+            size_t sent = 0;
+            while(sent < batch) {
+                size_t n = ring.push_n(f + sent, batch - sent);
+                sent += n;
+                if(n == 0) {
+                    this_thread::yield();
+                }
+            }
+            seq += batch;
+        }
+    }, [] {
+        frame f[batch];
+        for(long seq = 0; seq < items; ) {
+            size_t n = ring.pop_n(f, batch);
+            if(n == 0) {
+                this_thread::yield();
+            }
+            for(size_t i = 0; i < n; ++i) {
+                if(f[i].seq != seq++) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    });
+
+    // frames are written and read where they sit in the ring
+    bench("spsc reserve/peek", [] {
+        for(long seq = 0; seq < items; ) {
+            size_t n = batch;
+            frame *f = ring.reserve(n);
+            if(f == nullptr) {
+                this_thread::yield();
+                continue;
+            }
+            for(size_t i = 0; i < n; ++i) {
+                fill(f[i], seq++);
+            }
+            ring.commit(n);
+        }
+    }, [] {
+        for(long seq = 0; seq < items; ) {
+            size_t n = batch;
+            const frame *f = ring.peek(n);
+            if(f == nullptr) {
+                this_thread::yield();
+                continue;
+            }
+            for(size_t i = 0; i < n; ++i) {
+                if(f[i].seq != seq++) {
+                    return false;
+                }
+            }
+            ring.consume(n);
+        }
+        return true;
+    });
+    return 0;
+}
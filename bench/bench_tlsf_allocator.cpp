@@ -0,0 +1,89 @@
+#include "tlsf_allocator.h"
+#include "algorithm"
+#include "chrono"
+#include "cstdlib"
+#include "iostream"
+#include "memory"
+#include "random"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int live_slots = 1024;
+constexpr int operations = 1 << 20;
+
+struct op {
+    int slot;
+    size_t size;    // 0 frees the slot
+};
+
+// Randomized alloc/free trace over a fixed number of slots, so the same
+// sequence can be replayed against each allocator.
+vector<op> make_trace() {
+    mt19937 rng(42);
+    uniform_int_distribution<int> slot(0, live_slots - 1);
+    uniform_int_distribution<size_t> size(16, 4096);
+    vector<bool> used(live_slots, false);
+    vector<op> trace;
+    trace.reserve(operations);
+    for(int i = 0; i < operations; ++i) {
+        int k = slot(rng);
+        trace.push_back(op{k, used[k] ? 0 : size(rng)});
+        used[k] = !used[k];
+    }
+    return trace;
+}
+
+// Replays the trace and prints latency percentiles. `report` runs after
+// the trace, before the blocks still live are freed.
+template<class Alloc, class Free, class Report>
+void run(const char *name, const vector<op> &trace,
+        Alloc alloc, Free release, Report report) {
+    vector<void *> ptrs(live_slots, nullptr);
+    vector<op> live(live_slots, op{0, 0});
+    vector<double> ns;
+    ns.reserve(trace.size());
+    for(const op &o : trace) {
+        auto start = chrono::steady_clock::now();
+        if(o.size != 0) {
+            ptrs[o.slot] = alloc(o.size);
+        } else {
+            release(ptrs[o.slot], live[o.slot].size);
+        }
+        auto stop = chrono::steady_clock::now();
+        ns.push_back(chrono::duration<double, nano>(stop - start).count());
+        live[o.slot] = op{o.slot, o.size};
+    }
+    sort(ns.begin(), ns.end());
+    cout << name
+        << "\tp50=" << ns[ns.size() / 2]
+        << "\tp99=" << ns[ns.size() * 99 / 100]
+        << "\tp99.99=" << ns[ns.size() * 9999 / 10000]
+        << "\tmax=" << ns.back() << " ns" << endl;
+    report();
+    for(int k = 0; k < live_slots; ++k) {
+        if(live[k].size != 0) {
+            release(ptrs[k], live[k].size);
+        }
+    }
+}
+
+int main() {
+    auto trace = make_trace();
+
+    constexpr size_t region_size = size_t(16) << 20;
+    auto region = make_unique<unsigned char[]>(region_size);
+    tlsf_allocator<char> tlsf(region.get(), region_size);
+
+    run("tlsf", trace,
+        [&](size_t n) -> void * { return tlsf.allocate(n); },
+        [&](void *p, size_t n) { tlsf.deallocate(static_cast<char *>(p), n); },
+        [&] { cout << "tlsf\tfragmentation=" << tlsf.fragmentation() << endl; });
+
+    run("malloc", trace,
+        [](size_t n) -> void * { return malloc(n); },
+        [](void *p, size_t) { free(p); },
+        [] {});
+    return 0;
+}
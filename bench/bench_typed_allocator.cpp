@@ -0,0 +1,45 @@
+#include "typed_allocator.h"
+#include "bitmap_allocator.h"
+#include "chrono"
+#include "iostream"
+#include "memory"
+
+using namespace std;
+using namespace kcore;
+
+// Allocates the whole pool then frees it again, so every call runs against
+// a pool that is as full as it gets.
+template<template<class, int> class Pool, int N>
+void bench(const char *name, int rounds) {
+    auto pool = make_unique<Pool<long, N>>();
+    auto ptrs = make_unique<long *[]>(N);
+
+    auto start = chrono::steady_clock::now();
+    for(int r = 0; r < rounds; ++r) {
+        for(int i = 0; i < N; ++i) {
+            ptrs[i] = pool->allocate();
+        }
+        for(int i = 0; i < N; ++i) {
+            pool->deallocate(ptrs[i]);
+        }
+    }
+    auto stop = chrono::steady_clock::now();
+
+    double ns = chrono::duration<double, nano>(stop - start).count();
+    cout << name << "\tN=" << N << "\t" << ns / (2.0 * N * rounds) << " ns/op" << endl;
+}
+
+template<template<class, int> class Pool>
+void bench_all(const char *name) {
+    bench<Pool, 8>(name, 1 << 20);
+    bench<Pool, 64>(name, 1 << 17);
+    bench<Pool, 512>(name, 1 << 14);
+    bench<Pool, 4096>(name, 1 << 11);
+    bench<Pool, 65536>(name, 1 << 7);
+}
+
+int main() {
+    bench_all<typed_allocator>("typed_allocator");
+    bench_all<bitmap_allocator>("bitmap_allocator");
+    return 0;
+}
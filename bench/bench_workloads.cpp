@@ -0,0 +1,181 @@
+#include "harness.h"
+#include "concurrent_allocator.h"
+#include "typed_allocator.h"
+#include "algorithm"
+#include "atomic"
+#include "cstdlib"
+#include "memory"
+#include "random"
+#include "thread"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+constexpr int objects = 4096;
+
+struct message {
+    long payload[8];
+};
+
+// The three allocators every workload runs against, behind one interface.
+struct kcore_pool {
+    static constexpr const char *name = "typed_allocator";
+    typed_allocator<message, objects> pool;
+    auto allocate() -> message* { return pool.allocate(); }
+    auto deallocate(message *p) -> void { pool.deallocate(p); }
+};
+
+struct kcore_concurrent_pool {
+    static constexpr const char *name = "concurrent_allocator";
+    concurrent_allocator<message, objects> pool;
+    auto allocate() -> message* { return pool.allocate(); }
+    auto deallocate(message *p) -> void { pool.deallocate(p); }
+};
+
+struct c_heap {
+    static constexpr const char *name = "malloc";
+    auto allocate() -> message* { return static_cast<message *>(malloc(sizeof(message))); }
+    auto deallocate(message *p) -> void { free(p); }
+};
+
+struct cxx_heap {
+    static constexpr const char *name = "new";
+    auto allocate() -> message* { return new message; }
+    auto deallocate(message *p) -> void { delete p; }
+};
+
+template<class Alloc>
+void single_threaded(const bench::config &c, const vector<int> &order) {
+    auto alloc = make_unique<Alloc>();
+    vector<message *> live(objects);
+
+    auto fill = [&] {
+        for(int i = 0; i < objects; ++i) {
+            live[i] = alloc->allocate();
+        }
+        bench::keep(live);
+    };
+    auto release_all = [&] {
+        for(int i = 0; i < objects; ++i) {
+            alloc->deallocate(live[i]);
+        }
+    };
+
+    bench::run(c, Alloc::name, "allocate_only", objects, [] {}, fill, release_all);
+    bench::run(c, Alloc::name, "lifo", 2 * objects, [&] {
+        fill();
+        for(int i = objects - 1; i >= 0; --i) {
+            alloc->deallocate(live[i]);
+        }
+    });
+    bench::run(c, Alloc::name, "fifo", 2 * objects, [&] {
+        fill();
+        release_all();
+    });
+    bench::run(c, Alloc::name, "random", 2 * objects, [&] {
+        fill();
+        for(int i : order) {
+            alloc->deallocate(live[i]);
+        }
+    });
+}
+
+// Bounded single-producer/single-consumer queue of pointers.
+class handoff {
+    public:
+        auto push(message *p) -> bool {
+            size_t t = tail.load(memory_order_relaxed);
+            if(t - head.load(memory_order_acquire) == size) {
+                return false;
+            }
+            slots[t % size] = p;
+            tail.store(t + 1, memory_order_release);
+            return true;
+        }
+        auto pop() -> message* {
+            size_t h = head.load(memory_order_relaxed);
+            if(h == tail.load(memory_order_acquire)) {
+                return nullptr;
+            }
+            message *p = slots[h % size];
+            head.store(h + 1, memory_order_release);
+            return p;
+        }
+    private:
+        static constexpr size_t size = 256;
+        alignas(64) atomic<size_t> head{0};
+        alignas(64) atomic<size_t> tail{0};
+        message *slots[size];
+};
+
+// One thread allocates and hands objects over, the other frees them. The
+// consumer lives across all repetitions and is woken per round, so only
+// the hand-off is timed, not thread creation and join.
+template<class Alloc>
+void producer_consumer(const bench::config &c) {
+    auto alloc = make_unique<Alloc>();
+    handoff queue;
+    atomic<long> round{0};
+    atomic<long> done{0};
+    atomic<bool> stop{false};
+    thread consumer([&] {
+        bench::pin(c.cpu + 1);
+        for(long seen = 0; ; ) {
+            while(round.load(memory_order_acquire) == seen) {
+                this_thread::yield();
+            }
+            if(stop.load(memory_order_acquire)) {
+                return;
+            }
+            ++seen;
+            for(int i = 0; i < objects; ++i) {
+                message *p;
+                while((p = queue.pop()) == nullptr) {
+                    this_thread::yield();
+                }
+                alloc->deallocate(p);
+            }
+            done.store(seen, memory_order_release);
+        }
+    });
+    bench::run(c, Alloc::name, "producer_consumer", 2 * objects, [&] {
+        long r = round.fetch_add(1, memory_order_release) + 1;
+        for(int i = 0; i < objects; ++i) {
+            message *p;
+            while((p = alloc->allocate()) == nullptr) {
+                this_thread::yield();
+            }
+            while(!queue.push(p)) {
+                this_thread::yield();
+            }
+        }
+        while(done.load(memory_order_acquire) != r) {
+            this_thread::yield();
+        }
+    });
+    stop.store(true, memory_order_release);
+    round.fetch_add(1, memory_order_release);
+    consumer.join();
+}
+
+int main() {
+    bench::config c = bench::from_env();
+    bench::pin(c.cpu);
+
+    vector<int> order(objects);
+    for(int i = 0; i < objects; ++i) {
+        order[i] = i;
+    }
+    shuffle(order.begin(), order.end(), mt19937(1));
+
+    single_threaded<kcore_pool>(c, order);
+    single_threaded<c_heap>(c, order);
+    single_threaded<cxx_heap>(c, order);
+
+    // typed_allocator is not thread-safe; its lock-free sibling stands in.
+    producer_consumer<kcore_concurrent_pool>(c);
+    producer_consumer<c_heap>(c);
+    producer_consumer<cxx_heap>(c);
+    return 0;
+}
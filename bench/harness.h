@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Minimal benchmark harness.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+namespace bench {
+
+/*
+ * Every case runs `warmup` untimed repetitions, then `repetitions` timed
+ * ones; each timed repetition yields one ns/op sample. Results are printed
+ * one JSON object per line so runs can be diffed or loaded by scripts.
+ *
+ * BENCH_REPETITIONS and BENCH_CPU in the environment override the
+ * repetition count and the CPU the process is pinned to.
+ */
+struct config {
+    int warmup = 3;
+    int repetitions = 101;
+    int cpu = 0;
+};
+
+inline auto from_env() -> config {
+    config c;
+    if(const char *r = getenv("BENCH_REPETITIONS")) {
+        c.repetitions = atoi(r) > 0 ? atoi(r) : c.repetitions;
+    }
+    if(const char *cpu = getenv("BENCH_CPU")) {
+        c.cpu = atoi(cpu);
+    }
+    return c;
+}
+
+// Pins the calling thread so samples do not move between cores. Returns
+// false where pinning is unsupported or refused.
+inline auto pin(int cpu) -> bool {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+// Keeps the optimizer from dropping a value the benchmark computed.
+template<class T>
+inline void keep(T &&value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+/*
+ * Times `body`, which performs `ops` operations per call; `setup` and
+ * `teardown` run around every repetition, outside the timed region.
+ */
+template<class Setup, class Body, class Teardown>
+void run(const config &c, const char *allocator, const char *workload, long ops,
+        Setup setup, Body body, Teardown teardown) {
+    std::vector<double> samples;
+    samples.reserve(c.repetitions);
+    for(int i = 0; i < c.warmup + c.repetitions; ++i) {
+        setup();
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        teardown();
+        if(i >= c.warmup) {
+            samples.push_back(std::chrono::duration<double, std::nano>(stop - start).count() / ops);
+        }
+    }
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) {
+        size_t idx = static_cast<size_t>(q * (samples.size() - 1) + 0.5);
+        return samples[idx];
+    };
+    printf("{\"allocator\":\"%s\",\"workload\":\"%s\",\"ops\":%ld,\"repetitions\":%zu,"
+        "\"min_ns\":%.3f,\"median_ns\":%.3f,\"p99_ns\":%.3f,\"max_ns\":%.3f}\n",
+        allocator, workload, ops, samples.size(),
+        samples.front(), at(0.5), at(0.99), samples.back());
+    fflush(stdout);
+}
+
+template<class Body>
+void run(const config &c, const char *allocator, const char *workload, long ops, Body body) {
+    run(c, allocator, workload, ops, [] {}, body, [] {});
+}
+
+} /* bench */
+
+#endif /* BENCH_HARNESS_H_ */
@@ -42,7 +42,7 @@
 #define ALLOCATOR_H_
 
 #include "constants.h"
-#include "stl/kstddef.h"
+#include "stl/stddef.h"
 
 namespace KCORE_NAMESPACE {
 
@@ -80,12 +80,35 @@ concept bool allocate = requires(T a) {
     // { T::allocate(a) } -> typename T::value_type*;
 };
 
+// deallocate(p) returns the references left on p, 0 once its storage is
+// free again, or -1 for a pointer the pool did not hand out or already
+// took back.
 template<class T>
 concept bool deallocate = requires(T a, typename T::value_type *p) {
     { a.deallocate(p) } -> size_t;
     // { T::deallocate(a,p) } -> void;
 };
 
+template<class T>
+concept bool allocate_n = requires(T a, typename T::value_type **out, size_t n) {
+    { a.allocate_n(out, n) } -> size_t;
+};
+
+template<class T>
+concept bool deallocate_n = requires(T a, typename T::value_type **in, size_t n) {
+    { a.deallocate_n(in, n) } -> size_t;
+};
+
+template<class T>
+concept bool retain = requires(T a, typename T::value_type *p) {
+    { a.retain(p) } -> int;
+};
+
+template<class T>
+concept bool release = requires(T a, typename T::value_type *p, void (*dispose)(typename T::value_type *)) {
+    { a.release(p, dispose) } -> int;
+};
+
 } /* KCORE_INNER_NAMESPACE */
 
 template<class T>
@@ -100,6 +123,26 @@ concept bool array_allocator =
     KCORE_INNER_NAMESPACE::array_deallocate<T> &&
     KCORE_INNER_NAMESPACE::base_allocator<T>;
 
+// allocate_n(out, n) hands out up to n objects into out[] and returns how
+// many it got; deallocate_n(in, n) takes back n objects and returns how
+// many went back to the free pool.
+template<class T>
+concept bool batch_allocator = 
+    KCORE_INNER_NAMESPACE::allocate_n<T> &&
+    KCORE_INNER_NAMESPACE::deallocate_n<T> &&
+    KCORE_INNER_NAMESPACE::base_allocator<T>;
+
+// The pool keeps a reference count per object. retain(p) adds a
+// reference and returns the new count, or -1 if it cannot; release(p,
+// dispose) drops one and returns the remaining count, or -1 if p holds
+// none, calling dispose(p) before the storage is reused once none are
+// left.
+template<class T>
+concept bool shared_allocator = 
+    KCORE_INNER_NAMESPACE::retain<T> &&
+    KCORE_INNER_NAMESPACE::release<T> &&
+    allocator<T>;
+
 template<class T>
 concept bool extend_allocator = 
     KCORE_INNER_NAMESPACE::base_allocator<T> &&
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Opt-in allocator instrumentation.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef ALLOCATOR_STATS_H_
+#define ALLOCATOR_STATS_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+// Policy that records nothing; instrumented<Alloc, no_stats> adds no code
+// and no storage to Alloc.
+struct no_stats {
+    static constexpr bool enabled = false;
+};
+
+struct stats_snapshot {
+    static constexpr int buckets = 32;
+
+    const char *name;
+    size_t current;         // objects handed out right now
+    size_t peak;            // highest `current` seen
+    size_t allocations;
+    size_t deallocations;
+    size_t failures;        // allocations that returned nullptr
+    // Latency histograms: bucket i counts calls taking [2^(i-1), 2^i) ns,
+    // bucket 0 those under 1 ns, the last one everything slower.
+    uint64_t allocate_ns[buckets];
+    uint64_t deallocate_ns[buckets];
+};
+
+/*
+ * Policy that counts allocations and latencies. Every pool carrying it
+ * is linked into a process-wide registry, see pool_stats::for_each() and
+ * pool_stats::dump(). Counters are relaxed atomics, so pools used from
+ * several threads report sensible (if not instantaneous) numbers.
+ */
+class pool_stats {
+    public:
+        static constexpr bool enabled = true;
+        static constexpr int buckets = stats_snapshot::buckets;
+    public:
+        explicit pool_stats(const char *name = "pool") : name(name), current(0), peak(0),
+                allocations(0), deallocations(0), failures(0),
+                allocate_ns{}, deallocate_ns{}, next(nullptr) {
+            std::lock_guard<std::mutex> guard(registry_lock());
+            this->next = registry_head();
+            registry_head() = this;
+        }
+        pool_stats(const pool_stats &) = delete;
+        pool_stats(const pool_stats &&) = delete;
+        ~pool_stats() {
+            std::lock_guard<std::mutex> guard(registry_lock());
+            pool_stats **link = &registry_head();
+            while(*link != this) {
+                link = &(*link)->next;
+            }
+            *link = this->next;
+        }
+    public:
+        auto snapshot() const -> stats_snapshot {
+            stats_snapshot s;
+            s.name = this->name;
+            s.current = this->current.load(std::memory_order_relaxed);
+            s.peak = this->peak.load(std::memory_order_relaxed);
+            s.allocations = this->allocations.load(std::memory_order_relaxed);
+            s.deallocations = this->deallocations.load(std::memory_order_relaxed);
+            s.failures = this->failures.load(std::memory_order_relaxed);
+            for(int i = 0; i < buckets; ++i) {
+                s.allocate_ns[i] = this->allocate_ns[i].load(std::memory_order_relaxed);
+                s.deallocate_ns[i] = this->deallocate_ns[i].load(std::memory_order_relaxed);
+            }
+            return s;
+        }
+
+        // Calls f(const stats_snapshot &) for every live instrumented pool.
+        template<class F>
+        static auto for_each(F &&f) -> void {
+            std::lock_guard<std::mutex> guard(registry_lock());
+            for(pool_stats *s = registry_head(); s != nullptr; s = s->next) {
+                f(s->snapshot());
+            }
+        }
+
+        static auto dump(FILE *out = stdout) -> void {
+            for_each([out](const stats_snapshot &s) {
+                fprintf(out, "%s: current=%zu peak=%zu allocations=%zu deallocations=%zu failures=%zu\n",
+                    s.name, s.current, s.peak, s.allocations, s.deallocations, s.failures);
+                dump_histogram(out, "  allocate", s.allocate_ns);
+                dump_histogram(out, "  deallocate", s.deallocate_ns);
+            });
+        }
+
+    public:
+        // Hooks called by instrumented<>.
+        static auto now() -> uint64_t {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        auto on_allocate(size_t got, size_t wanted, uint64_t started) -> void {
+            record(this->allocate_ns, now() - started);
+            this->allocations.fetch_add(got, std::memory_order_relaxed);
+            if(got < wanted) {
+                this->failures.fetch_add(wanted - got, std::memory_order_relaxed);
+            }
+            size_t cur = this->current.fetch_add(got, std::memory_order_relaxed) + got;
+            size_t top = this->peak.load(std::memory_order_relaxed);
+            while(cur > top && !this->peak.compare_exchange_weak(top, cur, std::memory_order_relaxed)) {
+            }
+        }
+
+        auto on_deallocate(size_t freed, uint64_t started) -> void {
+            record(this->deallocate_ns, now() - started);
+            this->deallocations.fetch_add(freed, std::memory_order_relaxed);
+            this->current.fetch_sub(freed, std::memory_order_relaxed);
+        }
+
+    private:
+        static auto record(std::atomic<uint64_t> *histogram, uint64_t ns) -> void {
+            int bucket = ns == 0 ? 0 : 64 - __builtin_clzll(ns);
+            if(bucket >= buckets) {
+                bucket = buckets - 1;
+            }
+            histogram[bucket].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static auto dump_histogram(FILE *out, const char *label, const uint64_t *histogram) -> void {
+            fprintf(out, "%s ns:", label);
+            for(int i = 0; i < buckets; ++i) {
+                if(histogram[i] != 0) {
+                    fprintf(out, " <%llu:%llu", 1ULL << i, (unsigned long long)histogram[i]);
+                }
+            }
+            fprintf(out, "\n");
+        }
+
+        static auto registry_head() -> pool_stats *& {
+            static pool_stats *head = nullptr;
+            return head;
+        }
+
+        static auto registry_lock() -> std::mutex & {
+            static std::mutex lock;
+            return lock;
+        }
+
+    private:
+        const char *name;
+        std::atomic<size_t> current;
+        std::atomic<size_t> peak;
+        std::atomic<size_t> allocations;
+        std::atomic<size_t> deallocations;
+        std::atomic<size_t> failures;
+        std::atomic<uint64_t> allocate_ns[buckets];
+        std::atomic<uint64_t> deallocate_ns[buckets];
+        pool_stats *next;
+};
+
+// Build with KCORE_ALLOCATOR_STATS to instrument every pool that leaves
+// the policy defaulted.
+#if defined(KCORE_ALLOCATOR_STATS)
+using default_stats = pool_stats;
+#else
+using default_stats = no_stats;
+#endif
+
+/*
+ * Alloc carrying the Stats policy, constructed from a name followed by
+ * Alloc's own constructor arguments:
+ *
+ *     instrumented<typed_allocator<msg, 64>, pool_stats> msgs("msgs");
+ *
+ * Every allocation entry point Alloc has is wrapped by the Stats hooks;
+ * everything else (has(), available_count(), ...) is inherited as is.
+ */
+template<class Alloc, class Stats = default_stats>
+class instrumented : public Alloc {
+    public:
+        using value_type = typename Alloc::value_type;
+    public:
+        template<class... Args>
+        explicit instrumented(const char *name, Args&&... args)
+            : Alloc(std::forward<Args>(args)...), counters(name) {}
+    public:
+        auto allocate() -> value_type*
+            requires KCORE_INNER_NAMESPACE::allocate<Alloc> {
+            uint64_t started = Stats::now();
+            value_type *p = Alloc::allocate();
+            this->counters.on_allocate(p != nullptr, 1, started);
+            return p;
+        }
+
+        auto allocate(size_t n) -> value_type*
+            requires KCORE_INNER_NAMESPACE::array_allocate<Alloc> {
+            uint64_t started = Stats::now();
+            value_type *p = Alloc::allocate(n);
+            this->counters.on_allocate(p != nullptr, 1, started);
+            return p;
+        }
+
+        auto allocate(size_t n, const void *hint) -> value_type*
+            requires KCORE_INNER_NAMESPACE::array_allocate_with_hint<Alloc> {
+            uint64_t started = Stats::now();
+            value_type *p = Alloc::allocate(n, hint);
+            this->counters.on_allocate(p != nullptr, 1, started);
+            return p;
+        }
+
+        auto allocate_n(value_type **out, size_t n) -> size_t
+            requires KCORE_INNER_NAMESPACE::allocate_n<Alloc> {
+            uint64_t started = Stats::now();
+            size_t got = Alloc::allocate_n(out, n);
+            this->counters.on_allocate(got, n, started);
+            return got;
+        }
+
+        // Only a call that returns the slot to the pool (result 0) ends
+        // an allocation: a dropped reference leaves a positive count, and
+        // foreign pointers and double frees get -1.
+        auto deallocate(value_type *p)
+            requires KCORE_INNER_NAMESPACE::deallocate<Alloc> {
+            uint64_t started = Stats::now();
+            auto left = Alloc::deallocate(p);
+            this->counters.on_deallocate(left == 0, started);
+            return left;
+        }
+
+        // Same for dropping a shared reference, e.g. from pool_shared_ptr.
+        template<class Dispose>
+        auto release(value_type *p, Dispose &&dispose) -> int
+            requires KCORE_INNER_NAMESPACE::release<Alloc> {
+            uint64_t started = Stats::now();
+            int left = Alloc::release(p, std::forward<Dispose>(dispose));
+            this->counters.on_deallocate(left == 0, started);
+            return left;
+        }
+
+        auto deallocate(value_type *p, size_t n) -> void
+            requires KCORE_INNER_NAMESPACE::array_deallocate<Alloc> {
+            uint64_t started = Stats::now();
+            Alloc::deallocate(p, n);
+            this->counters.on_deallocate(p != nullptr, started);
+        }
+
+        auto deallocate_n(value_type **in, size_t n) -> size_t
+            requires KCORE_INNER_NAMESPACE::deallocate_n<Alloc> {
+            uint64_t started = Stats::now();
+            size_t freed = Alloc::deallocate_n(in, n);
+            this->counters.on_deallocate(freed, started);
+            return freed;
+        }
+
+    public:
+        auto stats() const -> const Stats & {
+            return this->counters;
+        }
+
+    private:
+        Stats counters;
+};
+
+// With no_stats nothing is wrapped: the pool is Alloc plus a constructor
+// that drops the name.
+template<class Alloc>
+class instrumented<Alloc, no_stats> : public Alloc {
+    public:
+        template<class... Args>
+        explicit instrumented(const char *, Args&&... args)
+            : Alloc(std::forward<Args>(args)...) {}
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* ALLOCATOR_STATS_H_ */
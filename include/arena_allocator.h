@@ -0,0 +1,240 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Monotonic arena allocator.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef ARENA_ALLOCATOR_H_
+#define ARENA_ALLOCATOR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace KCORE_NAMESPACE {
+
+// Upstream of an arena that never grows past its inline buffer.
+struct no_upstream {};
+
+namespace KCORE_INNER_NAMESPACE {
+
+struct arena_block {
+    arena_block *next;
+    unsigned char *begin;
+    unsigned char *end;
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+// Where an arena will place its next allocation.
+struct arena_checkpoint {
+    KCORE_INNER_NAMESPACE::arena_block *block;
+    unsigned char *ptr;
+};
+
+/*
+ * Bump-pointer allocator for memory that dies all at once. Allocation
+ * advances a pointer through an inline buffer of Size bytes; deallocate()
+ * only gives memory back when it is the most recent allocation. Memory is
+ * reclaimed in bulk with rewind() to a checkpoint, or reset().
+ *
+ * With an Upstream array_allocator the arena chains further Size byte
+ * blocks from it once the inline buffer is used up. Chained blocks are
+ * kept across rewind() and reset() for reuse, and only returned to the
+ * upstream when the arena is destroyed.
+ */
+template<class Tp, size_t Size, class Upstream = no_upstream>
+class arena_allocator {
+    static_assert(Size > sizeof(KCORE_INNER_NAMESPACE::arena_block),
+        "arena_allocator buffer is too small");
+    private:
+        using block = KCORE_INNER_NAMESPACE::arena_block;
+        static constexpr bool chained = !std::is_same_v<Upstream, no_upstream>;
+    public:
+        using value_type = Tp;
+    public:
+        arena_allocator() requires (!chained)
+            : first{nullptr, buffer, buffer + Size}, origin{&first, buffer}, upstream(nullptr) {
+            this->pos = this->origin;
+        }
+        explicit arena_allocator(Upstream &upstream) requires (chained)
+            : first{nullptr, buffer, buffer + Size}, origin{&first, buffer}, upstream(&upstream) {
+            this->pos = this->origin;
+        }
+        arena_allocator(const arena_allocator &) = delete;
+        arena_allocator(const arena_allocator &&) = delete;
+        ~arena_allocator() {
+            if constexpr (chained) {
+                block *b = this->first.next;
+                while(b != nullptr) {
+                    block *next = b->next;
+                    this->upstream->deallocate(
+                        reinterpret_cast<typename Upstream::value_type *>(b),
+                        block_units());
+                    b = next;
+                }
+            }
+        }
+    public:
+        // impl array_allocator
+        auto allocate(size_t n) -> Tp* {
+            if(n > SIZE_MAX / sizeof(Tp)) {
+                return nullptr;
+            }
+            size_t bytes = n * sizeof(Tp);
+            if(Tp *p = this->bump(bytes)) {
+                return p;
+            }
+            // Any further block is empty, so a request that does not fit
+            // the next one fits none of them: fail before taking blocks.
+            if(bytes > Size - sizeof(block)) {
+                return nullptr;
+            }
+            arena_checkpoint saved = this->pos;
+            if(!this->next_block()) {
+                return nullptr;
+            }
+            if(Tp *p = this->bump(bytes)) {
+                return p;
+            }
+            this->pos = saved;
+            return nullptr;
+        }
+
+        // Placement is always sequential, so the hint is not needed.
+        auto allocate(size_t n, const void *) -> Tp* {
+            return this->allocate(n);
+        }
+
+        auto deallocate(Tp *p, size_t n) -> void {
+            auto addr = reinterpret_cast<unsigned char *>(p);
+            if(addr + n * sizeof(Tp) == this->pos.ptr && addr >= this->pos.block->begin) {
+                this->pos.ptr = addr;
+            }
+        }
+
+    public:
+        auto checkpoint() const -> arena_checkpoint {
+            return this->pos;
+        }
+
+        // Frees everything allocated since `cp` was taken. Checkpoints taken
+        // after `cp` become invalid.
+        auto rewind(arena_checkpoint cp) -> void {
+            this->pos = cp;
+        }
+
+        auto reset() -> void {
+            this->pos = this->origin;
+        }
+
+        // Bytes left in the current block.
+        auto remaining() const -> size_t {
+            return this->pos.block->end - this->pos.ptr;
+        }
+
+    private:
+        static auto align(unsigned char *p) -> unsigned char * {
+            auto addr = reinterpret_cast<uintptr_t>(p);
+            addr = (addr + alignof(Tp) - 1) & ~(uintptr_t)(alignof(Tp) - 1);
+            return reinterpret_cast<unsigned char *>(addr);
+        }
+
+        // Upstream units per chained block, rounded up to cover Size bytes.
+        static constexpr auto block_units() -> size_t {
+            using unit = typename Upstream::value_type;
+            return (Size + sizeof(unit) - 1) / sizeof(unit);
+        }
+
+        // Places `bytes` in the current block, or returns null.
+        auto bump(size_t bytes) -> Tp * {
+            unsigned char *p = align(this->pos.ptr);
+            unsigned char *end = this->pos.block->end;
+            if(p > end || bytes > size_t(end - p)) {
+                return nullptr;
+            }
+            this->pos.ptr = p + bytes;
+            return reinterpret_cast<Tp *>(p);
+        }
+
+        auto next_block() -> bool {
+            block *b = this->pos.block->next;
+            if constexpr (chained) {
+                if(b == nullptr) {
+                    auto raw = this->upstream->allocate(
+                        block_units());
+                    if(raw == nullptr) {
+                        return false;
+                    }
+                    b = reinterpret_cast<block *>(raw);
+                    b->next = nullptr;
+                    b->begin = reinterpret_cast<unsigned char *>(b + 1);
+                    b->end = reinterpret_cast<unsigned char *>(b) + Size;
+                    this->pos.block->next = b;
+                }
+            }
+            if(b == nullptr) {
+                return false;
+            }
+            this->pos = arena_checkpoint{b, b->begin};
+            return true;
+        }
+
+    private:
+        alignas(alignof(std::max_align_t)) unsigned char buffer[Size];
+        block first;
+        const arena_checkpoint origin;
+        arena_checkpoint pos;
+        Upstream *upstream;
+};
+
+template<class T1, size_t S1, class U1, class T2, size_t S2, class U2>
+constexpr bool operator==( const arena_allocator<T1, S1, U1>& lhs, const arena_allocator<T2, S2, U2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class T1, size_t S1, class U1, class T2, size_t S2, class U2>
+constexpr bool operator!=( const arena_allocator<T1, S1, U1>& lhs, const arena_allocator<T2, S2, U2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* ARENA_ALLOCATOR_H_ */
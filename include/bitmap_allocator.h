@@ -0,0 +1,227 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Typed memory allocator with bitmap occupancy.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef BITMAP_ALLOCATOR_H_
+#define BITMAP_ALLOCATOR_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+
+#if !defined(KCORE_NO_SIMD) && (defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * Same interface as typed_allocator, but slot occupancy is one bit per
+ * slot instead of one byte. A set bit marks a free slot, so a free slot is
+ * found by skipping zero words and taking the lowest set bit.
+ */
+template<class Tp, int N> 
+class bitmap_allocator {
+    static_assert(N > 0, "bitmap_allocator needs at least one slot");
+    private:
+        static constexpr int word_bits = 64;
+        static constexpr int words = (N + word_bits - 1) / word_bits;
+
+        struct slot {
+            alignas(Tp) unsigned char data[sizeof(Tp)];
+        };
+    public:
+        bitmap_allocator() {
+            for(int i = 0; i < words; ++i) {
+                this->bitmap[i] = ~uint64_t(0);
+            }
+            if(N % word_bits != 0) {
+                this->bitmap[words - 1] = (uint64_t(1) << (N % word_bits)) - 1;
+            }
+            this->cursor = 0;
+        }
+        bitmap_allocator(const bitmap_allocator &) = delete;
+        bitmap_allocator(const bitmap_allocator &&) = delete;
+        ~bitmap_allocator() = default;
+    public:
+        using value_type = Tp;
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            int i = this->find_word(this->cursor);
+            this->cursor = i;
+            if(i == words) {
+                return nullptr;
+            }
+            int bit = __builtin_ctzll(this->bitmap[i]);
+            this->bitmap[i] &= this->bitmap[i] - 1;
+            return reinterpret_cast<Tp *>(this->mem[i * word_bits + bit].data);
+        }
+
+        auto deallocate(Tp *p) -> int {
+            if(this->has(p)) {
+                auto pos = this->index_of(p);
+                int i = static_cast<int>(pos / word_bits);
+                uint64_t bit = uint64_t(1) << (pos % word_bits);
+                if(this->bitmap[i] & bit) {
+                    return -1;      // already free
+                }
+                this->bitmap[i] |= bit;
+                if(i < this->cursor) {
+                    this->cursor = i;
+                }
+                return 0;
+            }
+            return -1;
+        }
+
+    public:
+        // impl batch_allocator
+        auto allocate_n(Tp **out, size_t n) -> size_t {
+            size_t got = 0;
+            int i = this->find_word(this->cursor);
+            while(got < n && i < words) {
+                uint64_t w = this->bitmap[i];
+                while(w != 0 && got < n) {
+                    out[got++] = reinterpret_cast<Tp *>(
+                        this->mem[i * word_bits + __builtin_ctzll(w)].data);
+                    w &= w - 1;
+                }
+                this->bitmap[i] = w;
+                if(w == 0) {
+                    i = this->find_word(i + 1);
+                }
+            }
+            this->cursor = i;
+            return got;
+        }
+
+        auto deallocate_n(Tp **in, size_t n) -> size_t {
+            size_t freed = 0;
+            int lowest = this->cursor;
+            for(size_t k = 0; k < n; ++k) {
+                if(!this->has(in[k])) {
+                    continue;
+                }
+                auto pos = this->index_of(in[k]);
+                int i = static_cast<int>(pos / word_bits);
+                uint64_t bit = uint64_t(1) << (pos % word_bits);
+                if(this->bitmap[i] & bit) {
+                    continue;
+                }
+                this->bitmap[i] |= bit;
+                lowest = i < lowest ? i : lowest;
+                ++freed;
+            }
+            this->cursor = lowest;
+            return freed;
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() const -> size_t {
+            size_t num_free = 0;
+            for(int i = 0; i < words; ++i) {
+                num_free += __builtin_popcountll(this->bitmap[i]);
+            }
+            return num_free;
+        }
+
+        auto has(Tp *ptr) const -> bool {
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            auto base = reinterpret_cast<const unsigned char *>(this->mem);
+            return addr >= base && addr < base + sizeof(slot) * N;
+        }
+
+    private:
+        auto index_of(Tp *ptr) const -> size_t {
+            return (reinterpret_cast<const unsigned char *>(ptr) -
+                reinterpret_cast<const unsigned char *>(this->mem)) / sizeof(slot);
+        }
+
+        // First word at or after `from` that still has a free slot, or
+        // `words` when the pool is full. Every word before `cursor` is full.
+        auto find_word(int from) const -> int {
+            int i = from;
+#if !defined(KCORE_NO_SIMD) && defined(__AVX2__)
+            for(; i + 4 <= words; i += 4) {
+                __m256i v = _mm256_loadu_si256(
+                    reinterpret_cast<const __m256i *>(this->bitmap + i));
+                if(!_mm256_testz_si256(v, v)) {
+                    break;
+                }
+            }
+#elif !defined(KCORE_NO_SIMD) && defined(__SSE2__)
+            const __m128i zero = _mm_setzero_si128();
+            for(; i + 2 <= words; i += 2) {
+                __m128i v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(this->bitmap + i));
+                if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xffff) {
+                    break;
+                }
+            }
+#endif
+            for(; i < words; ++i) {
+                if(this->bitmap[i] != 0) {
+                    break;
+                }
+            }
+            return i;
+        }
+
+    private:
+        slot mem[N];
+        uint64_t bitmap[words];
+        int cursor;
+};
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator==( const bitmap_allocator<T1, N1>& lhs, const bitmap_allocator<T2, N2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator!=( const bitmap_allocator<T1, N1>& lhs, const bitmap_allocator<T2, N2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* BITMAP_ALLOCATOR_H_ */
@@ -0,0 +1,348 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Binary buddy allocator with hint-aware placement.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef BUDDY_ALLOCATOR_H_
+#define BUDDY_ALLOCATOR_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+// Free-list links, stored inside the free block itself.
+struct buddy_link {
+    buddy_link *next;
+    buddy_link *prev;
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * Binary buddy allocator over a caller-provided region holding up to
+ * MaxBlocks blocks of 2^MaxLog2 bytes, handing out power-of-two blocks
+ * from 2^MinLog2 to 2^MaxLog2 bytes. Blocks are aligned to their size
+ * relative to the start of the region.
+ *
+ * Each order keeps a bitmap with one bit per block of that order, set
+ * while the block is free, next to an intrusive free list. The bitmap
+ * answers "is my buddy free" when merging and lets allocate(n, hint) look
+ * for a free block in the neighbourhood of `hint` before falling back to
+ * any free block. Splitting and merging walk at most one step per order.
+ */
+template<class Tp, int MinLog2, int MaxLog2, int MaxBlocks>
+class buddy_allocator {
+    static_assert(MinLog2 >= 5, "buddy_allocator blocks must hold the free-list links");
+    static_assert(MaxLog2 >= MinLog2 && MaxLog2 - MinLog2 < 32, "bad buddy_allocator order range");
+    static_assert(MaxBlocks > 0, "buddy_allocator needs at least one top-level block");
+    private:
+        using link = KCORE_INNER_NAMESPACE::buddy_link;
+
+        static constexpr int orders = MaxLog2 - MinLog2 + 1;
+
+        static constexpr auto blocks_at(int order) -> size_t {
+            return size_t(MaxBlocks) << (orders - 1 - order);
+        }
+
+        static constexpr auto bitmap_words() -> size_t {
+            size_t words = 0;
+            for(int k = 0; k < orders; ++k) {
+                words += (blocks_at(k) + 63) / 64;
+            }
+            return words;
+        }
+    public:
+        using value_type = Tp;
+
+        static constexpr size_t min_block = size_t(1) << MinLog2;
+        static constexpr size_t max_block = size_t(1) << MaxLog2;
+    public:
+        buddy_allocator(void *region, size_t bytes) : bitmap{}, lists{}, nonempty(0), free_total(0) {
+            this->base = static_cast<unsigned char *>(region);
+            this->top_blocks = bytes / max_block;
+            if(this->top_blocks > MaxBlocks) {
+                this->top_blocks = MaxBlocks;
+            }
+            size_t word = 0;
+            for(int k = 0; k < orders; ++k) {
+                this->bitmap_offset[k] = word;
+                word += (blocks_at(k) + 63) / 64;
+            }
+            for(size_t i = 0; i < this->top_blocks; ++i) {
+                this->push(orders - 1, i);
+            }
+        }
+        buddy_allocator(const buddy_allocator &) = delete;
+        buddy_allocator(const buddy_allocator &&) = delete;
+        ~buddy_allocator() = default;
+    public:
+        // impl array_allocator
+        auto allocate(size_t n) -> Tp* {
+            return this->allocate(n, nullptr);
+        }
+
+        // Prefers a free block close to `hint`, e.g. the buffer a new one
+        // will be used together with.
+        auto allocate(size_t n, const void *hint) -> Tp* {
+            if(n > SIZE_MAX / sizeof(Tp)) {
+                return nullptr;
+            }
+            int order = order_of(n * sizeof(Tp));
+            if(order >= orders) {
+                return nullptr;
+            }
+            uint32_t candidates = this->nonempty & (~uint32_t(0) << order);
+            if(candidates == 0) {
+                return nullptr;
+            }
+
+            int k = __builtin_ctz(candidates);
+            size_t idx = this->index_of(this->lists[k], k);
+            bool near = false;
+            size_t target = 0;
+            if(hint != nullptr && this->contains(hint)) {
+                // Closest free block around the hint over all large enough
+                // orders, measured to the start of the piece that would be
+                // split off it. Ties go to the lower order, which splits
+                // less; a block containing the hint wins outright.
+                target = static_cast<const unsigned char *>(hint) - this->base;
+                size_t best = ~size_t(0);
+                for(int j = order; j < orders && best != 0; ++j) {
+                    size_t found;
+                    if((this->nonempty & (uint32_t(1) << j)) &&
+                            this->nearest(j, target >> (MinLog2 + j), found)) {
+                        size_t begin = found << (MinLog2 + j);
+                        size_t end = begin + (size_t(1) << (MinLog2 + j));
+                        size_t distance = target < begin ? begin - target :
+                            target >= end ? target - (end - (min_block << order)) : 0;
+                        if(distance < best) {
+                            best = distance;
+                            k = j;
+                            idx = found;
+                            near = true;
+                        }
+                    }
+                }
+            }
+
+            this->pop(k, idx);
+            // Split down to the requested order, keeping the half on the
+            // side of the hint and freeing the other.
+            while(k > order) {
+                --k;
+                idx <<= 1;
+                size_t half = size_t(1) << (MinLog2 + k);
+                if(near && target >= (idx + 1) * half) {
+                    this->push(k, idx);
+                    idx += 1;
+                } else {
+                    this->push(k, idx + 1);
+                }
+            }
+            return reinterpret_cast<Tp *>(this->base + (idx << (MinLog2 + order)));
+        }
+
+        auto deallocate(Tp *p, size_t n) -> void {
+            if(p == nullptr || !this->contains(p) || n > SIZE_MAX / sizeof(Tp)) {
+                return;
+            }
+            int k = order_of(n * sizeof(Tp));
+            size_t idx = this->index_of(p, k);
+            if(k >= orders) {
+                return;
+            }
+            // Already free, on its own or as part of a merged block.
+            for(int j = k; j < orders; ++j) {
+                if(this->test(j, idx >> (j - k))) {
+                    return;
+                }
+            }
+            while(k < orders - 1 && this->test(k, idx ^ 1)) {
+                this->pop(k, idx ^ 1);
+                idx >>= 1;
+                ++k;
+            }
+            this->push(k, idx);
+        }
+
+    public:
+        auto has(Tp *ptr) const -> bool {
+            return this->contains(ptr);
+        }
+
+        auto free_bytes() const -> size_t {
+            return this->free_total;
+        }
+
+        auto largest_free_block() const -> size_t {
+            if(this->nonempty == 0) {
+                return 0;
+            }
+            return size_t(1) << (MinLog2 + 31 - __builtin_clz(this->nonempty));
+        }
+
+        // External fragmentation: 1 - largest free block / the largest
+        // block the free bytes could form if they were contiguous. Free
+        // memory never merges past max_block, so that caps the bound.
+        auto fragmentation() const -> double {
+            if(this->free_total == 0) {
+                return 0.0;
+            }
+            size_t ideal = this->free_total < max_block ? this->free_total : max_block;
+            return 1.0 - double(this->largest_free_block()) / double(ideal);
+        }
+
+    private:
+        // Order of the smallest block holding `bytes`; `orders` if none does.
+        static auto order_of(size_t bytes) -> int {
+            if(bytes <= min_block) {
+                return 0;
+            }
+            if(bytes > max_block) {
+                return orders;
+            }
+            return 64 - __builtin_clzll(bytes - 1) - MinLog2;
+        }
+
+        auto contains(const void *ptr) const -> bool {
+            auto addr = static_cast<const unsigned char *>(ptr);
+            return addr >= this->base && addr < this->base + this->top_blocks * max_block;
+        }
+
+        auto index_of(const void *ptr, int k) const -> size_t {
+            return size_t(static_cast<const unsigned char *>(ptr) - this->base) >> (MinLog2 + k);
+        }
+
+        auto word(int k, size_t idx) -> uint64_t & {
+            return this->bitmap[this->bitmap_offset[k] + idx / 64];
+        }
+
+        auto test(int k, size_t idx) -> bool {
+            return (this->word(k, idx) >> (idx % 64)) & 1;
+        }
+
+        // Free block of order k closest to block index `idx`, looking only
+        // at the bitmap word holding idx and its two neighbours.
+        auto nearest(int k, size_t idx, size_t &found) -> bool {
+            size_t words = (blocks_at(k) + 63) / 64;
+            size_t w = idx / 64;
+            uint64_t bits = this->word(k, idx);
+            int pos = static_cast<int>(idx % 64);
+            uint64_t above = bits & (~uint64_t(0) << pos);
+            uint64_t below = pos == 0 ? 0 : bits & (~uint64_t(0) >> (64 - pos));
+            if(above != 0 || below != 0) {
+                int up = above != 0 ? __builtin_ctzll(above) - pos : 64;
+                int down = below != 0 ? pos - (63 - __builtin_clzll(below)) : 64;
+                found = up <= down ? idx + up : idx - down;
+                return true;
+            }
+            if(w + 1 < words) {
+                uint64_t next = this->bitmap[this->bitmap_offset[k] + w + 1];
+                if(next != 0) {
+                    found = (w + 1) * 64 + __builtin_ctzll(next);
+                    return true;
+                }
+            }
+            if(w > 0) {
+                uint64_t prev = this->bitmap[this->bitmap_offset[k] + w - 1];
+                if(prev != 0) {
+                    found = (w - 1) * 64 + 63 - __builtin_clzll(prev);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        auto push(int k, size_t idx) -> void {
+            link *l = reinterpret_cast<link *>(this->base + (idx << (MinLog2 + k)));
+            l->prev = nullptr;
+            l->next = this->lists[k];
+            if(l->next != nullptr) {
+                l->next->prev = l;
+            }
+            this->lists[k] = l;
+            this->word(k, idx) |= uint64_t(1) << (idx % 64);
+            this->nonempty |= uint32_t(1) << k;
+            this->free_total += size_t(1) << (MinLog2 + k);
+        }
+
+        auto pop(int k, size_t idx) -> void {
+            link *l = reinterpret_cast<link *>(this->base + (idx << (MinLog2 + k)));
+            if(l->prev != nullptr) {
+                l->prev->next = l->next;
+            } else {
+                this->lists[k] = l->next;
+            }
+            if(l->next != nullptr) {
+                l->next->prev = l->prev;
+            }
+            if(this->lists[k] == nullptr) {
+                this->nonempty &= ~(uint32_t(1) << k);
+            }
+            this->word(k, idx) &= ~(uint64_t(1) << (idx % 64));
+            this->free_total -= size_t(1) << (MinLog2 + k);
+        }
+
+    private:
+        unsigned char *base;
+        size_t top_blocks;
+        uint64_t bitmap[bitmap_words()];
+        size_t bitmap_offset[orders];
+        link *lists[orders];
+        uint32_t nonempty;
+        size_t free_total;
+};
+
+template<class T1, int A1, int B1, int C1, class T2, int A2, int B2, int C2>
+constexpr bool operator==( const buddy_allocator<T1, A1, B1, C1>& lhs, const buddy_allocator<T2, A2, B2, C2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class T1, int A1, int B1, int C1, class T2, int A2, int B2, int C2>
+constexpr bool operator!=( const buddy_allocator<T1, A1, B1, C1>& lhs, const buddy_allocator<T2, A2, B2, C2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* BUDDY_ALLOCATOR_H_ */
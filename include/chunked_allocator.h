@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Growable typed allocator chaining fixed-size blocks.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef CHUNKED_ALLOCATOR_H_
+#define CHUNKED_ALLOCATOR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+template<size_t V>
+constexpr auto ceil_pow2() -> size_t {
+    size_t p = 1;
+    while(p < V) {
+        p <<= 1;
+    }
+    return p;
+}
+
+template<size_t V>
+constexpr auto log2_of() -> int {
+    int l = 0;
+    while((size_t(1) << l) < V) {
+        ++l;
+    }
+    return l;
+}
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * typed_allocator that grows. It starts with one block of BlockSlots
+ * slots taken from an Upstream array_allocator and chains up to MaxBlocks
+ * such blocks as demand rises. Every block keeps its own free list, and
+ * blocks with a free slot are linked in a list, so allocate() and
+ * deallocate() are O(1).
+ *
+ * Finding the block that owns a pointer is O(1) as well: the address is
+ * masked down to a power-of-two window at least as large as a block, and
+ * the window number is looked up in a small hash directory. A block
+ * touches at most two windows, so it is registered under both.
+ *
+ * Blocks that become completely empty are kept for reuse until more than
+ * keep_empty of them have piled up; past that they go back upstream.
+ *
+ * Each block ends in one live byte per slot, so deallocate() rejects a
+ * pointer that is not currently handed out, a double free included.
+ */
+template<class Tp, int BlockSlots, class Upstream, int MaxBlocks = 64>
+    requires array_allocator<Upstream>
+class chunked_allocator {
+    static_assert(BlockSlots > 0, "chunked_allocator blocks need at least one slot");
+    static_assert(MaxBlocks > 0, "chunked_allocator needs at least one block");
+    private:
+        union slot {
+            uint32_t next;
+            alignas(Tp) unsigned char data[sizeof(Tp)];
+        };
+
+        using upstream_type = typename Upstream::value_type;
+
+        static constexpr size_t slot_bytes = sizeof(slot) * BlockSlots;
+        static constexpr size_t block_units =
+            (slot_bytes + BlockSlots + sizeof(upstream_type) - 1) / sizeof(upstream_type);
+        static constexpr size_t block_bytes = block_units * sizeof(upstream_type);
+        static constexpr int window_log2 =
+            KCORE_INNER_NAMESPACE::log2_of<KCORE_INNER_NAMESPACE::ceil_pow2<block_bytes>()>();
+        static constexpr size_t directory_size =
+            KCORE_INNER_NAMESPACE::ceil_pow2<size_t(MaxBlocks) * 4>();
+
+        struct block {
+            unsigned char *base;
+            block *prev;        // in the list of blocks with a free slot
+            block *next;
+            uint32_t free_head; // slot index + 1, 0 ends the list
+            uint32_t watermark;
+            uint32_t used;
+            bool listed;
+        };
+
+        struct entry {
+            uintptr_t window;
+            block *owner;       // nullptr marks an empty entry
+        };
+    public:
+        using value_type = Tp;
+    public:
+        explicit chunked_allocator(Upstream &upstream, size_t keep_empty = SIZE_MAX)
+            : upstream(&upstream), keep_empty(keep_empty) {
+            for(int i = 0; i < MaxBlocks; ++i) {
+                this->blocks[i].base = nullptr;
+            }
+            for(size_t i = 0; i < directory_size; ++i) {
+                this->directory[i].owner = nullptr;
+            }
+            this->partial = nullptr;
+            this->held_blocks = 0;
+            this->empty_count = 0;
+            this->free_count = 0;
+            this->grow();
+        }
+        chunked_allocator(const chunked_allocator &) = delete;
+        chunked_allocator(const chunked_allocator &&) = delete;
+        ~chunked_allocator() {
+            for(int i = 0; i < MaxBlocks; ++i) {
+                if(this->blocks[i].base != nullptr) {
+                    this->upstream->deallocate(
+                        reinterpret_cast<upstream_type *>(this->blocks[i].base), block_units);
+                }
+            }
+        }
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            block *b = this->partial;
+            if(b == nullptr) {
+                b = this->grow();
+                if(b == nullptr) {
+                    return nullptr;
+                }
+            }
+            uint32_t pos;
+            if(b->free_head != 0) {
+                pos = b->free_head - 1;
+                b->free_head = this->slot_at(b, pos)->next;
+            } else {
+                pos = (b->watermark)++;
+            }
+            if((b->used)++ == 0) {
+                --(this->empty_count);
+            }
+            if(b->used == BlockSlots) {
+                this->unlink(b);
+            }
+            --(this->free_count);
+            live_of(b)[pos] = 1;
+            return reinterpret_cast<Tp *>(this->slot_at(b, pos)->data);
+        }
+
+        auto deallocate(Tp *p) -> int {
+            block *b = this->owner_of(p);
+            if(b == nullptr) {
+                return -1;
+            }
+            auto offset = static_cast<size_t>(reinterpret_cast<unsigned char *>(p) - b->base);
+            auto pos = static_cast<uint32_t>(offset / sizeof(slot));
+            // Slots past the watermark were never handed out, and their
+            // live bytes were never written.
+            if(offset % sizeof(slot) != 0 || pos >= b->watermark || live_of(b)[pos] == 0) {
+                return -1;
+            }
+            live_of(b)[pos] = 0;
+            this->slot_at(b, pos)->next = b->free_head;
+            b->free_head = pos + 1;
+            ++(this->free_count);
+            if(!b->listed) {
+                this->link(b);
+            }
+            if(--(b->used) == 0) {
+                ++(this->empty_count);
+                if(this->empty_count > this->keep_empty) {
+                    this->shrink(b);
+                }
+            }
+            return 0;
+        }
+
+    public:
+        // impl extend_allocator
+        // Free slots in the blocks held now; growth can add more.
+        auto available_count() const -> size_t {
+            return this->free_count;
+        }
+
+        auto has(Tp *ptr) const -> bool {
+            return this->owner_of(ptr) != nullptr;
+        }
+
+    public:
+        // Blocks currently taken from the upstream.
+        auto block_count() const -> size_t {
+            return this->held_blocks;
+        }
+
+    private:
+        auto slot_at(block *b, uint32_t pos) const -> slot * {
+            return reinterpret_cast<slot *>(b->base) + pos;
+        }
+
+        static auto live_of(block *b) -> unsigned char * {
+            return b->base + slot_bytes;
+        }
+
+        static auto window_of(uintptr_t addr) -> uintptr_t {
+            return addr >> window_log2;
+        }
+
+        static auto bucket_of(uintptr_t window) -> size_t {
+            return (window * 0x9e3779b97f4a7c15ULL) >> 32 & (directory_size - 1);
+        }
+
+        auto owner_of(const Tp *p) const -> block * {
+            auto addr = reinterpret_cast<uintptr_t>(p);
+            uintptr_t window = window_of(addr);
+            for(size_t i = bucket_of(window); this->directory[i].owner != nullptr;
+                    i = (i + 1) & (directory_size - 1)) {
+                const entry &e = this->directory[i];
+                auto base = reinterpret_cast<uintptr_t>(e.owner->base);
+                if(e.window == window && addr >= base && addr < base + slot_bytes) {
+                    return e.owner;
+                }
+            }
+            return nullptr;
+        }
+
+        auto enter(uintptr_t window, block *b) -> void {
+            size_t i = bucket_of(window);
+            while(this->directory[i].owner != nullptr) {
+                i = (i + 1) & (directory_size - 1);
+            }
+            this->directory[i] = entry{window, b};
+        }
+
+        // Linear probing deletion that shifts later entries back into the
+        // hole, so lookups never need tombstones.
+        auto erase(uintptr_t window, block *b) -> void {
+            size_t i = bucket_of(window);
+            while(this->directory[i].owner != b || this->directory[i].window != window) {
+                i = (i + 1) & (directory_size - 1);
+            }
+            size_t hole = i;
+            for(size_t j = (i + 1) & (directory_size - 1); this->directory[j].owner != nullptr;
+                    j = (j + 1) & (directory_size - 1)) {
+                size_t home = bucket_of(this->directory[j].window);
+                if(((j - home) & (directory_size - 1)) >= ((j - hole) & (directory_size - 1))) {
+                    this->directory[hole] = this->directory[j];
+                    hole = j;
+                }
+            }
+            this->directory[hole].owner = nullptr;
+        }
+
+        auto link(block *b) -> void {
+            b->prev = nullptr;
+            b->next = this->partial;
+            if(this->partial != nullptr) {
+                this->partial->prev = b;
+            }
+            this->partial = b;
+            b->listed = true;
+        }
+
+        auto unlink(block *b) -> void {
+            if(b->prev != nullptr) {
+                b->prev->next = b->next;
+            } else {
+                this->partial = b->next;
+            }
+            if(b->next != nullptr) {
+                b->next->prev = b->prev;
+            }
+            b->listed = false;
+        }
+
+        auto grow() -> block * {
+            if(this->held_blocks == MaxBlocks) {
+                return nullptr;
+            }
+            block *b = this->blocks;
+            while(b->base != nullptr) {
+                ++b;
+            }
+            auto raw = this->upstream->allocate(block_units);
+            if(raw == nullptr) {
+                return nullptr;
+            }
+            auto base = reinterpret_cast<unsigned char *>(raw);
+            if(reinterpret_cast<uintptr_t>(base) % alignof(slot) != 0) {
+                this->upstream->deallocate(raw, block_units);
+                return nullptr;
+            }
+            b->base = base;
+            b->free_head = 0;
+            b->watermark = 0;
+            b->used = 0;
+            this->link(b);
+            auto first = window_of(reinterpret_cast<uintptr_t>(base));
+            auto last = window_of(reinterpret_cast<uintptr_t>(base) + slot_bytes - 1);
+            this->enter(first, b);
+            if(last != first) {
+                this->enter(last, b);
+            }
+            ++(this->held_blocks);
+            ++(this->empty_count);
+            this->free_count += BlockSlots;
+            return b;
+        }
+
+        auto shrink(block *b) -> void {
+            this->unlink(b);
+            auto first = window_of(reinterpret_cast<uintptr_t>(b->base));
+            auto last = window_of(reinterpret_cast<uintptr_t>(b->base) + slot_bytes - 1);
+            this->erase(first, b);
+            if(last != first) {
+                this->erase(last, b);
+            }
+            this->upstream->deallocate(reinterpret_cast<upstream_type *>(b->base), block_units);
+            b->base = nullptr;
+            --(this->held_blocks);
+            --(this->empty_count);
+            this->free_count -= BlockSlots;
+        }
+
+    private:
+        Upstream *upstream;
+        size_t keep_empty;
+        block *partial;
+        size_t held_blocks;
+        size_t empty_count;
+        size_t free_count;
+        block blocks[MaxBlocks];
+        entry directory[directory_size];
+};
+
+template<class T1, int B1, class U1, int M1, class T2, int B2, class U2, int M2>
+constexpr bool operator==( const chunked_allocator<T1, B1, U1, M1>& lhs, const chunked_allocator<T2, B2, U2, M2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class T1, int B1, class U1, int M1, class T2, int B2, class U2, int M2>
+constexpr bool operator!=( const chunked_allocator<T1, B1, U1, M1>& lhs, const chunked_allocator<T2, B2, U2, M2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* CHUNKED_ALLOCATOR_H_ */
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Lock-free typed memory allocator.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef CONCURRENT_ALLOCATOR_H_
+#define CONCURRENT_ALLOCATOR_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * Thread-safe counterpart of typed_allocator. Free slots form a Treiber
+ * stack whose head packs the top slot index with a generation tag that
+ * changes on every push and pop, so a stale compare-exchange fails
+ * instead of corrupting the list (ABA).
+ *
+ * Count is the per-slot reference count, as for typed_allocator; pick a
+ * wider unsigned type than the default for heavily shared objects.
+ */
+template<class Tp, int N, class Count = unsigned char> 
+class concurrent_allocator {
+    static_assert(N > 0, "concurrent_allocator needs at least one slot");
+    static_assert(std::atomic<Count>::is_always_lock_free,
+        "concurrent_allocator counts must be lock-free atomics");
+    static_assert(static_cast<uint64_t>(N) < 0xffffffffULL,
+        "concurrent_allocator slot index must fit in 32 bits");
+    private:
+        static constexpr uint64_t index_mask = 0xffffffffULL;
+
+        struct slot {
+            alignas(Tp) unsigned char data[sizeof(Tp)];
+        };
+    public:
+        concurrent_allocator() {
+            for(int i = 0; i < N; ++i) {
+                this->next[i].store(static_cast<uint32_t>(i + 1), std::memory_order_relaxed);
+                this->used[i].store(0, std::memory_order_relaxed);
+            }
+            this->head.store(0, std::memory_order_relaxed);
+            this->free_count.store(N, std::memory_order_release);
+        }
+        concurrent_allocator(const concurrent_allocator &) = delete;
+        concurrent_allocator(const concurrent_allocator &&) = delete;
+        ~concurrent_allocator() = default;
+    public:
+        using value_type = Tp;
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            uint64_t old = this->head.load(std::memory_order_acquire);
+            uint64_t top;
+            do {
+                top = old & index_mask;
+                if(top == N) {
+                    return nullptr;
+                }
+                uint64_t below = this->next[top].load(std::memory_order_relaxed);
+                uint64_t tag = (old >> 32) + 1;
+                if(this->head.compare_exchange_weak(old, (tag << 32) | below,
+                        std::memory_order_acquire, std::memory_order_acquire)) {
+                    break;
+                }
+            } while(true);
+            this->used[top].store(1, std::memory_order_relaxed);
+            this->free_count.fetch_sub(1, std::memory_order_relaxed);
+            return reinterpret_cast<Tp *>(this->mem[top].data);
+        }
+
+        auto deallocate(Tp *p) -> int {
+            return this->release(p, [](Tp *) {});
+        }
+
+    public:
+        // impl shared_allocator
+        // used[] is the slot's reference count; it saturates at the largest
+        // Count.
+        auto retain(Tp *p) -> int {
+            if(!this->has(p)) {
+                return -1;
+            }
+            auto &refs = this->used[this->index_of(p)];
+            Count n = refs.load(std::memory_order_relaxed);
+            do {
+                if(n == 0 || n == std::numeric_limits<Count>::max()) {
+                    return -1;
+                }
+            } while(!refs.compare_exchange_weak(n, static_cast<Count>(n + 1), std::memory_order_relaxed));
+            return n + 1;
+        }
+
+        // Drops one reference. The thread dropping the last one calls
+        // dispose(p) before the slot is pushed back, so no other thread can
+        // have been handed the slot yet.
+        template<class Dispose>
+        auto release(Tp *p, Dispose &&dispose) -> int {
+            if(!this->has(p)) {
+                return -1;
+            }
+            auto pos = this->index_of(p);
+            int left = this->unref(pos);
+            if(left != 0) {
+                return left < 0 ? 0 : left;
+            }
+            dispose(p);
+            uint64_t old = this->head.load(std::memory_order_relaxed);
+            uint64_t tag;
+            do {
+                this->next[pos].store(static_cast<uint32_t>(old & index_mask),
+                    std::memory_order_relaxed);
+                tag = (old >> 32) + 1;
+            } while(!this->head.compare_exchange_weak(old, (tag << 32) | pos,
+                        std::memory_order_release, std::memory_order_relaxed));
+            this->free_count.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+
+    public:
+        // impl batch_allocator
+        // The whole batch is unlinked or linked with a single CAS on head.
+        auto allocate_n(Tp **out, size_t n) -> size_t {
+            uint64_t old = this->head.load(std::memory_order_acquire);
+            size_t got;
+            do {
+                got = 0;
+                uint64_t top = old & index_mask;
+                while(got < n && top != N) {
+                    out[got++] = reinterpret_cast<Tp *>(this->mem[top].data);
+                    top = this->next[top].load(std::memory_order_relaxed);
+                }
+                if(got == 0) {
+                    return 0;
+                }
+                uint64_t tag = (old >> 32) + 1;
+                if(this->head.compare_exchange_weak(old, (tag << 32) | top,
+                        std::memory_order_acquire, std::memory_order_acquire)) {
+                    break;
+                }
+            } while(true);
+            for(size_t i = 0; i < got; ++i) {
+                this->used[this->index_of(out[i])].store(1, std::memory_order_relaxed);
+            }
+            this->free_count.fetch_sub(static_cast<int>(got), std::memory_order_relaxed);
+            return got;
+        }
+
+        auto deallocate_n(Tp **in, size_t n) -> size_t {
+            size_t freed = 0;
+            uint32_t first = N;
+            uint32_t last = N;
+            for(size_t i = 0; i < n; ++i) {
+                if(!this->has(in[i])) {
+                    continue;
+                }
+                auto pos = static_cast<uint32_t>(this->index_of(in[i]));
+                if(this->unref(pos) != 0) {
+                    continue;
+                }
+                if(last != N) {
+                    this->next[last].store(pos, std::memory_order_relaxed);
+                } else {
+                    first = pos;
+                }
+                last = pos;
+                ++freed;
+            }
+            if(freed == 0) {
+                return 0;
+            }
+            uint64_t old = this->head.load(std::memory_order_relaxed);
+            uint64_t tag;
+            do {
+                this->next[last].store(static_cast<uint32_t>(old & index_mask),
+                    std::memory_order_relaxed);
+                tag = (old >> 32) + 1;
+            } while(!this->head.compare_exchange_weak(old, (tag << 32) | first,
+                        std::memory_order_release, std::memory_order_relaxed));
+            this->free_count.fetch_add(static_cast<int>(freed), std::memory_order_relaxed);
+            return freed;
+        }
+
+    public:
+        // impl extend_allocator
+        // Only a snapshot: other threads may allocate or free concurrently.
+        auto available_count() const -> size_t {
+            int num_free = this->free_count.load(std::memory_order_relaxed);
+            return num_free < 0 ? 0 : static_cast<size_t>(num_free);
+        }
+
+        auto has(Tp *ptr) const -> bool {
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            auto base = reinterpret_cast<const unsigned char *>(this->mem);
+            return addr >= base && addr < base + sizeof(slot) * N;
+        }
+
+    private:
+        auto index_of(Tp *ptr) const -> size_t {
+            return (reinterpret_cast<const unsigned char *>(ptr) -
+                reinterpret_cast<const unsigned char *>(this->mem)) / sizeof(slot);
+        }
+
+        // Decrements used[pos] unless it is already zero (a double free),
+        // returning the new count or -1 in that case. The acq_rel order
+        // makes every holder's writes visible to whoever drops the last
+        // reference.
+        auto unref(size_t pos) -> int {
+            auto &refs = this->used[pos];
+            Count n = refs.load(std::memory_order_relaxed);
+            do {
+                if(n == 0) {
+                    return -1;
+                }
+            } while(!refs.compare_exchange_weak(n, static_cast<Count>(n - 1), std::memory_order_acq_rel,
+                        std::memory_order_relaxed));
+            return n - 1;
+        }
+
+    private:
+        // head and free_count sit on their own cache lines, away from the
+        // slots and from each other.
+        alignas(KCORE_CACHE_LINE) std::atomic<uint64_t> head;
+        alignas(KCORE_CACHE_LINE) std::atomic<int> free_count;
+        alignas(KCORE_CACHE_LINE) std::atomic<uint32_t> next[N];
+        std::atomic<Count> used[N];
+        slot mem[N];
+};
+
+template< class T1, int N1, class C1, class T2, int N2, class C2>
+constexpr bool operator==( const concurrent_allocator<T1, N1, C1>& lhs, const concurrent_allocator<T2, N2, C2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template< class T1, int N1, class C1, class T2, int N2, class C2>
+constexpr bool operator!=( const concurrent_allocator<T1, N1, C1>& lhs, const concurrent_allocator<T2, N2, C2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* CONCURRENT_ALLOCATOR_H_ */
@@ -46,6 +46,12 @@
 #define KCORE_INNER_NAMESPACE inner
 
 
+// Bytes per cache line, used to keep data written by different threads
+// apart.
+#ifndef KCORE_CACHE_LINE
+#define KCORE_CACHE_LINE 64
+#endif
+
 #ifndef KCORE_USE_STL
 #define KCORE_USE_STL
 #endif
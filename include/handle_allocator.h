@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Typed allocator handing out generational handles.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef HANDLE_ALLOCATOR_H_
+#define HANDLE_ALLOCATOR_H_
+
+#include "constants.h"
+#include "typed_allocator.h"
+#include "stl/string.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+template<unsigned long V>
+constexpr auto bit_width() -> int {
+    int bits = 0;
+    for(unsigned long v = V; v != 0; v >>= 1) {
+        ++bits;
+    }
+    return bits;
+}
+
+// Bits needed to name every one of N slots.
+template<long N>
+constexpr int handle_index_bits = bit_width<static_cast<unsigned long>(N - 1)>() > 0 ?
+    bit_width<static_cast<unsigned long>(N - 1)>() : 1;
+
+// Fewest generation bits a handle may have: with g bits a stale handle
+// aliases after 2^(g-1) reuses of its slot, 2048 here.
+constexpr int min_generation_bits = 12;
+
+// 16-bit handles while they keep min_generation_bits, else 32-bit.
+template<long N>
+using handle_bits_t = std::conditional_t<
+    (handle_index_bits<N> <= 16 - min_generation_bits), uint16_t, uint32_t>;
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * Index plus generation of a pool slot, packed into one unsigned word
+ * as (generation << index_bits) | index. The all-zero handle is null.
+ */
+template<class Bits>
+struct generational_handle {
+    Bits bits = 0;
+
+    explicit operator bool() const {
+        return this->bits != 0;
+    }
+};
+
+template<class Bits>
+constexpr bool operator==( const generational_handle<Bits>& lhs, const generational_handle<Bits>& rhs ) {
+    return lhs.bits == rhs.bits;
+}
+
+template<class Bits>
+constexpr bool operator!=( const generational_handle<Bits>& lhs, const generational_handle<Bits>& rhs ) {
+    return lhs.bits != rhs.bits;
+}
+
+/*
+ * typed_allocator that can also name its slots with small handles instead
+ * of pointers. Each slot carries a generation counter that is bumped when
+ * the slot is handed out and again when it is freed, so it is odd exactly
+ * while the slot is live. A handle records the generation it was issued
+ * with; once the slot is freed or reused, resolving it yields nullptr.
+ * Generations wrap, so a handle kept across 2^(generation_bits - 1)
+ * reuses of one slot can alias again.
+ *
+ * Handles are 16-bit for up to 16 slots and 32-bit otherwise; Bits picks
+ * another unsigned width, e.g. uint64_t for more generations. Either way
+ * at least 12 bits are left for the generation.
+ */
+template<class Tp, int N, class Bits = KCORE_INNER_NAMESPACE::handle_bits_t<N>>
+class handle_allocator {
+    static_assert(N > 0, "handle_allocator needs at least one slot");
+    static_assert(std::is_unsigned_v<Bits>, "handle_allocator handles are unsigned words");
+    static_assert(int(sizeof(Bits) * 8) - KCORE_INNER_NAMESPACE::handle_index_bits<N> >=
+            KCORE_INNER_NAMESPACE::min_generation_bits,
+        "handle_allocator handles must leave 12 generation bits next to the slot index");
+    private:
+        using index_type = KCORE_INNER_NAMESPACE::slot_index_t<N>;
+        using bits_type = Bits;
+
+        static constexpr int index_bits = KCORE_INNER_NAMESPACE::handle_index_bits<N>;
+    public:
+        static constexpr int generation_bits = int(sizeof(bits_type) * 8) - index_bits;
+    private:
+        static constexpr bits_type index_mask = bits_type((1ULL << index_bits) - 1);
+        static constexpr bits_type generation_mask = bits_type((1ULL << generation_bits) - 1);
+
+        union slot {
+            index_type next;
+            alignas(Tp) unsigned char data[sizeof(Tp)];
+        };
+    public:
+        handle_allocator() {
+            memset(this->generation, 0, sizeof(this->generation));
+            this->free_head = 0;
+            this->watermark = 0;
+            this->used = 0;
+        }
+        handle_allocator(const handle_allocator &) = delete;
+        handle_allocator(const handle_allocator &&) = delete;
+        ~handle_allocator() = default;
+    public:
+        using value_type = Tp;
+        using handle = generational_handle<bits_type>;
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            return this->resolve(this->allocate_handle());
+        }
+
+        auto deallocate(Tp *p) -> int {
+            if(!this->has(p)) {
+                return -1;
+            }
+            return this->free_slot(this->index_of(p)) ? 0 : -1;
+        }
+
+    public:
+        auto allocate_handle() -> handle {
+            index_type pos;
+            if(this->free_head != 0) {
+                pos = this->free_head - 1;
+                this->free_head = this->mem[pos].next;
+            } else if(this->watermark < N) {
+                pos = (this->watermark)++;
+            } else {
+                return handle{};
+            }
+            ++(this->used);
+            bits_type gen = this->bump(pos);
+            return handle{bits_type((gen << index_bits) | pos)};
+        }
+
+        // Frees the slot h names; -1 if h is null or stale.
+        auto deallocate(handle h) -> int {
+            if(this->resolve(h) == nullptr) {
+                return -1;
+            }
+            this->free_slot(h.bits & index_mask);
+            return 0;
+        }
+
+        // O(1): one mask, one shift and one compare against the slot's
+        // current generation.
+        auto resolve(handle h) const -> Tp * {
+            size_t pos = h.bits & index_mask;
+            bits_type gen = bits_type(h.bits >> index_bits);
+            if((gen & 1) == 0 || pos >= N || this->generation[pos] != gen) {
+                return nullptr;
+            }
+            return const_cast<Tp *>(reinterpret_cast<const Tp *>(this->mem[pos].data));
+        }
+
+        // Handle for a live object of this pool, or null.
+        auto handle_of(const Tp *p) const -> handle {
+            if(!this->has(p)) {
+                return handle{};
+            }
+            size_t pos = this->index_of(p);
+            bits_type gen = this->generation[pos];
+            if((gen & 1) == 0) {
+                return handle{};
+            }
+            return handle{bits_type((gen << index_bits) | pos)};
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() const -> size_t {
+            return N - this->used;
+        }
+
+        auto has(const Tp *ptr) const -> bool {
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            auto base = reinterpret_cast<const unsigned char *>(this->mem);
+            return addr >= base && addr < base + sizeof(slot) * N;
+        }
+
+    private:
+        auto index_of(const Tp *ptr) const -> size_t {
+            return (reinterpret_cast<const unsigned char *>(ptr) -
+                reinterpret_cast<const unsigned char *>(this->mem)) / sizeof(slot);
+        }
+
+        auto bump(size_t pos) -> bits_type {
+            this->generation[pos] = bits_type((this->generation[pos] + 1) & generation_mask);
+            return this->generation[pos];
+        }
+
+        auto free_slot(size_t pos) -> bool {
+            if((this->generation[pos] & 1) == 0) {
+                return false;
+            }
+            this->bump(pos);
+            this->mem[pos].next = this->free_head;
+            this->free_head = static_cast<index_type>(pos + 1);
+            --(this->used);
+            return true;
+        }
+
+    private:
+        slot mem[N];
+        bits_type generation[N];
+        index_type free_head;
+        index_type watermark;
+        index_type used;
+};
+
+template< class T1, int N1, class B1, class T2, int N2, class B2>
+constexpr bool operator==( const handle_allocator<T1, N1, B1>& lhs, const handle_allocator<T2, N2, B2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template< class T1, int N1, class B1, class T2, int N2, class B2>
+constexpr bool operator!=( const handle_allocator<T1, N1, B1>& lhs, const handle_allocator<T2, N2, B2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* HANDLE_ALLOCATOR_H_ */
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Intrusive singly and doubly linked lists.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef INTRUSIVE_LIST_H_
+#define INTRUSIVE_LIST_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <iterator>
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * Hooks are base classes of the element type, so linking an object costs
+ * no allocation. Tag tells several hooks of one type apart:
+ *
+ *     struct by_deadline {};
+ *     struct timer : slist_hook<>, list_hook<by_deadline> { ... };
+ *
+ * An object is in at most one list per hook and must be unlinked before
+ * it is destroyed. Copying an element does not copy its links: a copy
+ * starts out unlinked, and assignment leaves the target's links alone.
+ */
+template<class Tag = void>
+struct slist_hook {
+    slist_hook *next = nullptr;
+
+    slist_hook() = default;
+    slist_hook(const slist_hook &) {}
+    auto operator=(const slist_hook &) -> slist_hook & { return *this; }
+};
+
+template<class Tag = void>
+struct list_hook {
+    list_hook *prev = nullptr;
+    list_hook *next = nullptr;
+
+    list_hook() = default;
+    list_hook(const list_hook &) {}
+    auto operator=(const list_hook &) -> list_hook & { return *this; }
+
+    // Whether the object is in a list through this hook.
+    auto linked() const -> bool {
+        return this->next != nullptr;
+    }
+};
+
+/*
+ * Singly linked list in the manner of Contiki's list: O(1) push at both
+ * ends and pop at the front, O(n) removal of an arbitrary element.
+ */
+template<class T, class Tag = void>
+class intrusive_slist {
+    private:
+        using hook = slist_hook<Tag>;
+    public:
+        class iterator {
+            public:
+                using iterator_category = std::forward_iterator_tag;
+                using value_type = T;
+                using difference_type = ptrdiff_t;
+                using pointer = T *;
+                using reference = T &;
+                using rvalue_reference = T &&;
+            public:
+                iterator() : node(nullptr) {}
+                explicit iterator(hook *node) : node(node) {}
+
+                auto operator*() const -> T & { return *owner(this->node); }
+                auto operator->() const -> T * { return owner(this->node); }
+                auto operator++() -> iterator & {
+                    this->node = this->node->next;
+                    return *this;
+                }
+                auto operator++(int) -> iterator {
+                    iterator old = *this;
+                    ++(*this);
+                    return old;
+                }
+                auto operator==(const iterator &other) const -> bool { return this->node == other.node; }
+                auto operator!=(const iterator &other) const -> bool { return this->node != other.node; }
+
+            private:
+                hook *node;
+        };
+        using value_type = T;
+    public:
+        intrusive_slist() : head(nullptr), tail(nullptr), count(0) {}
+        intrusive_slist(const intrusive_slist &) = delete;
+        intrusive_slist(const intrusive_slist &&) = delete;
+        ~intrusive_slist() {
+            this->clear();
+        }
+    public:
+        auto begin() const -> iterator { return iterator(this->head); }
+        auto end() const -> iterator { return iterator(); }
+        auto empty() const -> bool { return this->head == nullptr; }
+        auto size() const -> size_t { return this->count; }
+        auto front() const -> T & { return *owner(this->head); }
+        auto back() const -> T & { return *owner(this->tail); }
+
+        auto push_front(T &obj) -> void {
+            hook *h = &obj;
+            h->next = this->head;
+            this->head = h;
+            if(this->tail == nullptr) {
+                this->tail = h;
+            }
+            ++(this->count);
+        }
+
+        auto push_back(T &obj) -> void {
+            hook *h = &obj;
+            h->next = nullptr;
+            if(this->tail != nullptr) {
+                this->tail->next = h;
+            } else {
+                this->head = h;
+            }
+            this->tail = h;
+            ++(this->count);
+        }
+
+        auto pop_front() -> T * {
+            hook *h = this->head;
+            if(h == nullptr) {
+                return nullptr;
+            }
+            this->head = h->next;
+            if(this->head == nullptr) {
+                this->tail = nullptr;
+            }
+            h->next = nullptr;
+            --(this->count);
+            return owner(h);
+        }
+
+        auto insert_after(T &pos, T &obj) -> void {
+            hook *p = &pos;
+            hook *h = &obj;
+            h->next = p->next;
+            p->next = h;
+            if(this->tail == p) {
+                this->tail = h;
+            }
+            ++(this->count);
+        }
+
+        // Unlinks obj if it is in the list; O(n).
+        auto remove(T &obj) -> bool {
+            hook *h = &obj;
+            hook *prev = nullptr;
+            for(hook *cur = this->head; cur != nullptr; prev = cur, cur = cur->next) {
+                if(cur != h) {
+                    continue;
+                }
+                if(prev != nullptr) {
+                    prev->next = cur->next;
+                } else {
+                    this->head = cur->next;
+                }
+                if(this->tail == cur) {
+                    this->tail = prev;
+                }
+                cur->next = nullptr;
+                --(this->count);
+                return true;
+            }
+            return false;
+        }
+
+        auto clear() -> void {
+            while(this->pop_front() != nullptr) {
+            }
+        }
+
+    private:
+        static auto owner(hook *h) -> T * {
+            return static_cast<T *>(h);
+        }
+
+    private:
+        hook *head;
+        hook *tail;
+        size_t count;
+};
+
+/*
+ * Circular doubly linked list around a sentinel hook held by the list:
+ * O(1) push and pop at both ends, insertion before any position and
+ * removal of any element.
+ */
+template<class T, class Tag = void>
+class intrusive_list {
+    private:
+        using hook = list_hook<Tag>;
+    public:
+        class iterator {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = T;
+                using difference_type = ptrdiff_t;
+                using pointer = T *;
+                using reference = T &;
+                using rvalue_reference = T &&;
+            public:
+                iterator() : node(nullptr) {}
+                explicit iterator(hook *node) : node(node) {}
+
+                auto operator*() const -> T & { return *owner(this->node); }
+                auto operator->() const -> T * { return owner(this->node); }
+                auto operator++() -> iterator & {
+                    this->node = this->node->next;
+                    return *this;
+                }
+                auto operator++(int) -> iterator {
+                    iterator old = *this;
+                    ++(*this);
+                    return old;
+                }
+                auto operator--() -> iterator & {
+                    this->node = this->node->prev;
+                    return *this;
+                }
+                auto operator--(int) -> iterator {
+                    iterator old = *this;
+                    --(*this);
+                    return old;
+                }
+                auto operator==(const iterator &other) const -> bool { return this->node == other.node; }
+                auto operator!=(const iterator &other) const -> bool { return this->node != other.node; }
+
+            private:
+                friend class intrusive_list;
+                hook *node;
+        };
+        using value_type = T;
+    public:
+        intrusive_list() : count(0) {
+            this->sentinel.prev = &this->sentinel;
+            this->sentinel.next = &this->sentinel;
+        }
+        intrusive_list(const intrusive_list &) = delete;
+        intrusive_list(const intrusive_list &&) = delete;
+        ~intrusive_list() {
+            this->clear();
+        }
+    public:
+        auto begin() -> iterator { return iterator(this->sentinel.next); }
+        auto end() -> iterator { return iterator(&this->sentinel); }
+        auto empty() const -> bool { return this->count == 0; }
+        auto size() const -> size_t { return this->count; }
+        auto front() -> T & { return *owner(this->sentinel.next); }
+        auto back() -> T & { return *owner(this->sentinel.prev); }
+
+        // Links obj in front of pos and returns its position.
+        auto insert(iterator pos, T &obj) -> iterator {
+            hook *h = &obj;
+            hook *at = pos.node;
+            h->prev = at->prev;
+            h->next = at;
+            at->prev->next = h;
+            at->prev = h;
+            ++(this->count);
+            return iterator(h);
+        }
+
+        auto push_front(T &obj) -> void {
+            this->insert(this->begin(), obj);
+        }
+
+        auto push_back(T &obj) -> void {
+            this->insert(this->end(), obj);
+        }
+
+        // Unlinks the element at pos and returns the position after it.
+        auto erase(iterator pos) -> iterator {
+            hook *h = pos.node;
+            hook *next = h->next;
+            h->prev->next = next;
+            next->prev = h->prev;
+            h->prev = nullptr;
+            h->next = nullptr;
+            --(this->count);
+            return iterator(next);
+        }
+
+        // obj must be in this list.
+        auto remove(T &obj) -> void {
+            this->erase(this->iterator_to(obj));
+        }
+
+        auto pop_front() -> T * {
+            if(this->empty()) {
+                return nullptr;
+            }
+            T *obj = owner(this->sentinel.next);
+            this->erase(this->begin());
+            return obj;
+        }
+
+        auto pop_back() -> T * {
+            if(this->empty()) {
+                return nullptr;
+            }
+            T *obj = owner(this->sentinel.prev);
+            this->erase(iterator(this->sentinel.prev));
+            return obj;
+        }
+
+        auto iterator_to(T &obj) -> iterator {
+            return iterator(static_cast<hook *>(&obj));
+        }
+
+        auto clear() -> void {
+            while(this->pop_front() != nullptr) {
+            }
+        }
+
+    private:
+        static auto owner(hook *h) -> T * {
+            return static_cast<T *>(h);
+        }
+
+    private:
+        hook sentinel;
+        size_t count;
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* INTRUSIVE_LIST_H_ */
@@ -0,0 +1,367 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Intrusive AVL tree.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef INTRUSIVE_TREE_H_
+#define INTRUSIVE_TREE_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <functional>
+#include <iterator>
+
+namespace KCORE_NAMESPACE {
+
+// Base class hook of intrusive_tree elements; see list_hook for Tag and
+// for what copying an element does to its links.
+template<class Tag = void>
+struct tree_hook {
+    tree_hook *parent = nullptr;
+    tree_hook *left = nullptr;
+    tree_hook *right = nullptr;
+    int height = 0;     // 0 while unlinked, 1 for a leaf
+
+    tree_hook() = default;
+    tree_hook(const tree_hook &) {}
+    auto operator=(const tree_hook &) -> tree_hook & { return *this; }
+};
+
+/*
+ * Ordered multiset of objects linked through their tree_hook, kept
+ * balanced as an AVL tree: insert(), erase() and find() are O(log n) and
+ * never allocate. Compare orders two elements; find() and lower_bound()
+ * also accept any key Compare can order against an element.
+ *
+ *     struct session : tree_hook<> { uint32_t id; ... };
+ *     struct by_id {
+ *         bool operator()(const session &a, const session &b) const { return a.id < b.id; }
+ *         bool operator()(const session &a, uint32_t id) const { return a.id < id; }
+ *         bool operator()(uint32_t id, const session &b) const { return id < b.id; }
+ *     };
+ *     intrusive_tree<session, by_id> sessions;
+ */
+template<class T, class Compare = std::less<T>, class Tag = void>
+class intrusive_tree {
+    private:
+        using hook = tree_hook<Tag>;
+    public:
+        class iterator {
+            public:
+                using iterator_category = std::bidirectional_iterator_tag;
+                using value_type = T;
+                using difference_type = ptrdiff_t;
+                using pointer = T *;
+                using reference = T &;
+                using rvalue_reference = T &&;
+            public:
+                iterator() : node(nullptr), tree(nullptr) {}
+                iterator(hook *node, const intrusive_tree *tree) : node(node), tree(tree) {}
+
+                auto operator*() const -> T & { return *owner(this->node); }
+                auto operator->() const -> T * { return owner(this->node); }
+                auto operator++() -> iterator & {
+                    this->node = successor(this->node);
+                    return *this;
+                }
+                auto operator++(int) -> iterator {
+                    iterator old = *this;
+                    ++(*this);
+                    return old;
+                }
+                // Decrementing end() yields the last element.
+                auto operator--() -> iterator & {
+                    this->node = this->node == nullptr ?
+                        rightmost(this->tree->root) : predecessor(this->node);
+                    return *this;
+                }
+                auto operator--(int) -> iterator {
+                    iterator old = *this;
+                    --(*this);
+                    return old;
+                }
+                auto operator==(const iterator &other) const -> bool { return this->node == other.node; }
+                auto operator!=(const iterator &other) const -> bool { return this->node != other.node; }
+
+            private:
+                friend class intrusive_tree;
+                hook *node;
+                const intrusive_tree *tree;
+        };
+        using value_type = T;
+    public:
+        explicit intrusive_tree(Compare comp = Compare()) : root(nullptr), count(0), comp(comp) {}
+        intrusive_tree(const intrusive_tree &) = delete;
+        intrusive_tree(const intrusive_tree &&) = delete;
+        ~intrusive_tree() {
+            this->clear();
+        }
+    public:
+        auto begin() const -> iterator { return iterator(leftmost(this->root), this); }
+        auto end() const -> iterator { return iterator(nullptr, this); }
+        auto empty() const -> bool { return this->root == nullptr; }
+        auto size() const -> size_t { return this->count; }
+
+        // Links obj after any elements equal to it.
+        auto insert(T &obj) -> iterator {
+            hook *h = &obj;
+            hook *parent = nullptr;
+            hook **link = &this->root;
+            while(*link != nullptr) {
+                parent = *link;
+                link = this->comp(obj, *owner(parent)) ? &parent->left : &parent->right;
+            }
+            h->parent = parent;
+            h->left = nullptr;
+            h->right = nullptr;
+            h->height = 1;
+            *link = h;
+            ++(this->count);
+            this->rebalance(parent);
+            return iterator(h, this);
+        }
+
+        // Unlinks the element at pos and returns the position after it.
+        auto erase(iterator pos) -> iterator {
+            hook *h = pos.node;
+            iterator next(successor(h), this);
+            hook *fix;
+            if(h->left != nullptr && h->right != nullptr) {
+                // Put the successor, which has no left child, in h's place.
+                hook *s = leftmost(h->right);
+                if(s->parent != h) {
+                    fix = s->parent;
+                    this->replace(s, s->right);
+                    s->right = h->right;
+                    s->right->parent = s;
+                } else {
+                    fix = s;
+                }
+                this->replace(h, s);
+                s->left = h->left;
+                s->left->parent = s;
+                s->height = h->height;
+            } else {
+                fix = h->parent;
+                this->replace(h, h->left != nullptr ? h->left : h->right);
+            }
+            h->parent = h->left = h->right = nullptr;
+            h->height = 0;
+            --(this->count);
+            this->rebalance(fix);
+            return next;
+        }
+
+        // obj must be in this tree.
+        auto remove(T &obj) -> void {
+            this->erase(this->iterator_to(obj));
+        }
+
+        auto iterator_to(T &obj) const -> iterator {
+            return iterator(static_cast<hook *>(&obj), this);
+        }
+
+        // First element not ordered before key.
+        template<class K>
+        auto lower_bound(const K &key) const -> iterator {
+            hook *best = nullptr;
+            for(hook *n = this->root; n != nullptr; ) {
+                if(this->comp(*owner(n), key)) {
+                    n = n->right;
+                } else {
+                    best = n;
+                    n = n->left;
+                }
+            }
+            return iterator(best, this);
+        }
+
+        template<class K>
+        auto find(const K &key) const -> iterator {
+            iterator it = this->lower_bound(key);
+            if(it.node != nullptr && this->comp(key, *owner(it.node))) {
+                return this->end();
+            }
+            return it;
+        }
+
+        // Unlinks every element, in O(n).
+        auto clear() -> void {
+            hook *h = this->root;
+            while(h != nullptr) {
+                if(h->left != nullptr) {
+                    h = h->left;
+                } else if(h->right != nullptr) {
+                    h = h->right;
+                } else {
+                    // A leaf: detach it from its parent and go back up.
+                    hook *parent = h->parent;
+                    if(parent != nullptr) {
+                        (parent->left == h ? parent->left : parent->right) = nullptr;
+                    }
+                    h->parent = nullptr;
+                    h->height = 0;
+                    h = parent;
+                }
+            }
+            this->root = nullptr;
+            this->count = 0;
+        }
+
+    private:
+        static auto owner(hook *h) -> T * {
+            return static_cast<T *>(h);
+        }
+
+        static auto height(const hook *h) -> int {
+            return h == nullptr ? 0 : h->height;
+        }
+
+        static auto update(hook *h) -> void {
+            int l = height(h->left);
+            int r = height(h->right);
+            h->height = (l > r ? l : r) + 1;
+        }
+
+        static auto leftmost(hook *h) -> hook * {
+            while(h != nullptr && h->left != nullptr) {
+                h = h->left;
+            }
+            return h;
+        }
+
+        static auto rightmost(hook *h) -> hook * {
+            while(h != nullptr && h->right != nullptr) {
+                h = h->right;
+            }
+            return h;
+        }
+
+        static auto successor(hook *h) -> hook * {
+            if(h->right != nullptr) {
+                return leftmost(h->right);
+            }
+            while(h->parent != nullptr && h->parent->right == h) {
+                h = h->parent;
+            }
+            return h->parent;
+        }
+
+        static auto predecessor(hook *h) -> hook * {
+            if(h->left != nullptr) {
+                return rightmost(h->left);
+            }
+            while(h->parent != nullptr && h->parent->left == h) {
+                h = h->parent;
+            }
+            return h->parent;
+        }
+
+        // Puts `by` (possibly null) where `old` hangs in the tree.
+        auto replace(hook *old, hook *by) -> void {
+            hook *parent = old->parent;
+            if(parent == nullptr) {
+                this->root = by;
+            } else if(parent->left == old) {
+                parent->left = by;
+            } else {
+                parent->right = by;
+            }
+            if(by != nullptr) {
+                by->parent = parent;
+            }
+        }
+
+        auto rotate_left(hook *x) -> hook * {
+            hook *y = x->right;
+            x->right = y->left;
+            if(y->left != nullptr) {
+                y->left->parent = x;
+            }
+            this->replace(x, y);
+            y->left = x;
+            x->parent = y;
+            update(x);
+            update(y);
+            return y;
+        }
+
+        auto rotate_right(hook *x) -> hook * {
+            hook *y = x->left;
+            x->left = y->right;
+            if(y->right != nullptr) {
+                y->right->parent = x;
+            }
+            this->replace(x, y);
+            y->right = x;
+            x->parent = y;
+            update(x);
+            update(y);
+            return y;
+        }
+
+        // Restores heights and balance from h up to the root.
+        auto rebalance(hook *h) -> void {
+            while(h != nullptr) {
+                update(h);
+                int balance = height(h->left) - height(h->right);
+                if(balance > 1) {
+                    if(height(h->left->left) < height(h->left->right)) {
+                        this->rotate_left(h->left);
+                    }
+                    h = this->rotate_right(h);
+                } else if(balance < -1) {
+                    if(height(h->right->right) < height(h->right->left)) {
+                        this->rotate_right(h->right);
+                    }
+                    h = this->rotate_left(h);
+                }
+                h = h->parent;
+            }
+        }
+
+    private:
+        hook *root;
+        size_t count;
+        Compare comp;
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* INTRUSIVE_TREE_H_ */
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Per-thread magazine cache in front of a shared allocator.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef MAGAZINE_ALLOCATOR_H_
+#define MAGAZINE_ALLOCATOR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * A small LIFO stack of free objects sitting in front of a shared pool.
+ * Each thread owns its own magazine, typically as
+ *
+ *     thread_local magazine_allocator<pool_type, 32> cache(shared_pool);
+ *
+ * so allocate() and deallocate() touch only thread-private memory until
+ * the magazine runs empty or full, at which point half of it is refilled
+ * from or flushed to the backing pool in one batch.
+ *
+ * Objects are fungible: an object allocated through one thread's magazine
+ * may be freed through another's, it simply ends up in that magazine (or
+ * back in the pool). The backing pool therefore has to be thread-safe
+ * when magazines live on several threads.
+ */
+template<allocator Alloc, int M = 32>
+class magazine_allocator {
+    static_assert(M >= 2, "magazine_allocator needs room for at least two objects");
+    public:
+        using value_type = typename Alloc::value_type;
+    public:
+        explicit magazine_allocator(Alloc &backing) : backing(backing), top(0) {}
+        magazine_allocator(const magazine_allocator &) = delete;
+        magazine_allocator(const magazine_allocator &&) = delete;
+        ~magazine_allocator() {
+            this->flush(this->top);
+        }
+    public:
+        // impl allocator
+        auto allocate() -> value_type* {
+            if(this->top == 0 && this->refill(M / 2) == 0) {
+                return nullptr;
+            }
+            return this->rounds[--(this->top)];
+        }
+
+        // Rounds are only checked against the backing pool's range: a
+        // double free is not detected here and the round may be handed
+        // out twice.
+        auto deallocate(value_type *p) -> int {
+            if constexpr (extend_allocator<Alloc>) {
+                if(!this->backing.has(p)) {
+                    return -1;
+                }
+            }
+            if(this->top == M) {
+                this->flush(M / 2);
+            }
+            this->rounds[(this->top)++] = p;
+            return 0;
+        }
+
+    public:
+        // impl batch_allocator
+        auto allocate_n(value_type **out, size_t n) -> size_t {
+            size_t got = 0;
+            while(got < n) {
+                if(this->top == 0 && this->refill(M / 2) == 0) {
+                    break;
+                }
+                while(got < n && this->top > 0) {
+                    out[got++] = this->rounds[--(this->top)];
+                }
+            }
+            return got;
+        }
+
+        auto deallocate_n(value_type **in, size_t n) -> size_t {
+            size_t freed = 0;
+            for(size_t i = 0; i < n; ++i) {
+                if(this->deallocate(in[i]) == 0) {
+                    ++freed;
+                }
+            }
+            return freed;
+        }
+
+    public:
+        // impl extend_allocator, when the backing pool does
+        auto available_count() -> size_t
+            requires extend_allocator<Alloc> {
+            return this->top + this->backing.available_count();
+        }
+
+        auto has(value_type *ptr) -> bool
+            requires extend_allocator<Alloc> {
+            return this->backing.has(ptr);
+        }
+
+    public:
+        // Number of objects currently cached by this magazine.
+        auto cached_count() const -> size_t {
+            return this->top;
+        }
+
+        // Hands every cached object back to the backing pool.
+        auto drain() -> void {
+            this->flush(this->top);
+        }
+
+        auto upstream() const -> Alloc & {
+            return this->backing;
+        }
+
+    private:
+        auto refill(int n) -> int {
+            int got = 0;
+            if constexpr (batch_allocator<Alloc>) {
+                got = static_cast<int>(this->backing.allocate_n(this->rounds + this->top, n));
+                this->top += got;
+            } else {
+                for(; got < n; ++got) {
+                    value_type *p = this->backing.allocate();
+                    if(p == nullptr) {
+                        break;
+                    }
+                    this->rounds[(this->top)++] = p;
+                }
+            }
+            return got;
+        }
+
+        auto flush(int n) -> void {
+            if constexpr (batch_allocator<Alloc>) {
+                this->top -= n;
+                this->backing.deallocate_n(this->rounds + this->top, n);
+            } else {
+                for(int i = 0; i < n; ++i) {
+                    this->backing.deallocate(this->rounds[--(this->top)]);
+                }
+            }
+        }
+
+    private:
+        Alloc &backing;
+        int top;
+        value_type *rounds[M];
+};
+
+template<class A1, int M1, class A2, int M2>
+constexpr bool operator==( const magazine_allocator<A1, M1>& lhs, const magazine_allocator<A2, M2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class A1, int M1, class A2, int M2>
+constexpr bool operator!=( const magazine_allocator<A1, M1>& lhs, const magazine_allocator<A2, M2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* MAGAZINE_ALLOCATOR_H_ */
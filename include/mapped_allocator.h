@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Typed allocator persisted in a memory-mapped file.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef MAPPED_ALLOCATOR_H_
+#define MAPPED_ALLOCATOR_H_
+
+#include "constants.h"
+#include "typed_allocator.h"
+#include "stl/string.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+// FNV-1a, continuing from `h`.
+inline auto fnv1a(const void *data, size_t bytes, uint64_t h = 0xcbf29ce484222325ULL) -> uint64_t {
+    auto p = static_cast<const unsigned char *>(data);
+    for(size_t i = 0; i < bytes; ++i) {
+        h = (h ^ p[i]) * 0x100000001b3ULL;
+    }
+    return h;
+}
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * typed_allocator whose slots and occupancy live in a file mapped with
+ * MAP_SHARED, so its contents survive a restart. Nothing in the file is
+ * a pointer: free list links are slot indices and callers keep offsets
+ * (offset_of(), at()) rather than addresses, so the file may be mapped
+ * anywhere next time.
+ *
+ * The header carries a checksum over itself and the occupancy table. It
+ * is written by sync() and by the destructor, and cleared by the first
+ * allocate() or deallocate() after that, so a file left behind by a crash
+ * or by a pool of another shape fails validation and is formatted afresh;
+ * attached() tells the two cases apart. If the file cannot be opened or mapped the pool has
+ * no slots.
+ */
+template<class Tp, int N>
+class mapped_allocator {
+    static_assert(N > 0, "mapped_allocator needs at least one slot");
+    static_assert(std::is_trivially_copyable_v<Tp>,
+        "mapped_allocator objects are persisted byte for byte");
+    private:
+        using index_type = KCORE_INNER_NAMESPACE::slot_index_t<N>;
+
+        static constexpr uint64_t magic = 0x6b636f72652d6d61ULL; // "kcore-ma"
+        static constexpr uint32_t version = 1;
+
+        union slot {
+            index_type next;
+            alignas(Tp) unsigned char data[sizeof(Tp)];
+        };
+
+        struct header {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t slot_size;
+            uint64_t capacity;
+            uint64_t free_head;
+            uint64_t watermark;
+            uint64_t used;
+            uint64_t checksum;  // 0 while changed since the last seal
+        };
+
+        struct layout {
+            header head;
+            char count[N];
+            slot mem[N];
+        };
+    public:
+        explicit mapped_allocator(const char *path) : file(nullptr), recovered(false) {
+            int fd = open(path, O_RDWR | O_CREAT, 0600);
+            if(fd < 0) {
+                return;
+            }
+            struct stat st;
+            bool sized = fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) == sizeof(layout);
+            if(!sized && ftruncate(fd, sizeof(layout)) != 0) {
+                close(fd);
+                return;
+            }
+            void *addr = mmap(nullptr, sizeof(layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            close(fd);
+            if(addr == MAP_FAILED) {
+                return;
+            }
+            this->file = static_cast<layout *>(addr);
+            this->recovered = sized && this->valid();
+            if(!this->recovered) {
+                this->format();
+            }
+        }
+        mapped_allocator(const mapped_allocator &) = delete;
+        mapped_allocator(const mapped_allocator &&) = delete;
+        ~mapped_allocator() {
+            if(this->file != nullptr) {
+                this->seal();
+                munmap(this->file, sizeof(layout));
+            }
+        }
+    public:
+        using value_type = Tp;
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            if(this->file == nullptr) {
+                return nullptr;
+            }
+            header &h = this->file->head;
+            index_type pos;
+            if(h.free_head != 0) {
+                pos = static_cast<index_type>(h.free_head - 1);
+                h.free_head = this->file->mem[pos].next;
+            } else if(h.watermark < N) {
+                pos = static_cast<index_type>((h.watermark)++);
+            } else {
+                return nullptr;
+            }
+            h.checksum = 0;
+            ++(h.used);
+            ++(this->file->count[pos]);
+            return reinterpret_cast<Tp *>(this->file->mem[pos].data);
+        }
+
+        auto deallocate(Tp *p) -> int {
+            if(!this->has(p)) {
+                return -1;
+            }
+            header &h = this->file->head;
+            auto pos = this->index_of(p);
+            if(this->file->count[pos] == 0) {
+                return -1;
+            }
+            h.checksum = 0;
+            if(--(this->file->count[pos]) == 0) {
+                this->file->mem[pos].next = static_cast<index_type>(h.free_head);
+                h.free_head = pos + 1;
+                --(h.used);
+            }
+            return this->file->count[pos];
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() const -> size_t {
+            return this->file == nullptr ? 0 : N - this->file->head.used;
+        }
+
+        auto has(const Tp *ptr) const -> bool {
+            if(this->file == nullptr) {
+                return false;
+            }
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            auto base = reinterpret_cast<const unsigned char *>(this->file->mem);
+            return addr >= base && addr < base + sizeof(slot) * N;
+        }
+
+    public:
+        auto is_open() const -> bool {
+            return this->file != nullptr;
+        }
+
+        // Whether the constructor found a valid pool in the file rather
+        // than formatting it.
+        auto attached() const -> bool {
+            return this->recovered;
+        }
+
+        // Mapping-independent name of an object, and back.
+        auto offset_of(const Tp *p) const -> size_t {
+            return reinterpret_cast<const unsigned char *>(p) -
+                reinterpret_cast<const unsigned char *>(this->file);
+        }
+
+        auto at(size_t offset) const -> Tp * {
+            return reinterpret_cast<Tp *>(reinterpret_cast<unsigned char *>(this->file) + offset);
+        }
+
+        // Calls f(Tp *) for every live object, e.g. to rebuild indexes
+        // after attaching.
+        template<class F>
+        auto for_each(F &&f) -> void {
+            if(this->file == nullptr) {
+                return;
+            }
+            for(size_t i = 0; i < this->file->head.watermark; ++i) {
+                if(this->file->count[i] > 0) {
+                    f(reinterpret_cast<Tp *>(this->file->mem[i].data));
+                }
+            }
+        }
+
+        // Seals the header and flushes the mapping to the file. The pool
+        // stays usable; the next allocate() or deallocate() breaks the
+        // seal again.
+        auto sync() -> void {
+            if(this->file != nullptr) {
+                this->seal();
+            }
+        }
+
+    private:
+        auto index_of(const Tp *ptr) const -> size_t {
+            return (reinterpret_cast<const unsigned char *>(ptr) -
+                reinterpret_cast<const unsigned char *>(this->file->mem)) / sizeof(slot);
+        }
+
+        auto seal() -> void {
+            this->file->head.checksum = this->checksum();
+            msync(this->file, sizeof(layout), MS_SYNC);
+        }
+
+        auto checksum() const -> uint64_t {
+            header h = this->file->head;
+            h.checksum = 0;
+            uint64_t sum = KCORE_INNER_NAMESPACE::fnv1a(&h, sizeof(h));
+            sum = KCORE_INNER_NAMESPACE::fnv1a(this->file->count, N, sum);
+            return sum == 0 ? 1 : sum;
+        }
+
+        auto valid() const -> bool {
+            const header &h = this->file->head;
+            return h.magic == magic && h.version == version &&
+                h.slot_size == sizeof(slot) && h.capacity == N &&
+                h.checksum == this->checksum();
+        }
+
+        auto format() -> void {
+            memset(this->file->count, 0, N);
+            header &h = this->file->head;
+            h.magic = magic;
+            h.version = version;
+            h.slot_size = sizeof(slot);
+            h.capacity = N;
+            h.free_head = 0;
+            h.watermark = 0;
+            h.used = 0;
+        }
+
+    private:
+        layout *file;
+        bool recovered;
+};
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator==( const mapped_allocator<T1, N1>& lhs, const mapped_allocator<T2, N2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator!=( const mapped_allocator<T1, N1>& lhs, const mapped_allocator<T2, N2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* MAPPED_ALLOCATOR_H_ */
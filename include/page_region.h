@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Huge-page backed memory regions for pools.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef PAGE_REGION_H_
+#define PAGE_REGION_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KCORE_NAMESPACE {
+
+// What a page_region is backed by, from most to least preferred.
+enum class page_backing {
+    hugetlb,        // explicit huge pages from the hugetlbfs pool
+    transparent,    // normal mapping marked MADV_HUGEPAGE for THP
+    normal,         // base pages
+    none,           // mapping failed
+};
+
+inline auto backing_name(page_backing b) -> const char * {
+    switch(b) {
+        case page_backing::hugetlb: return "hugetlb";
+        case page_backing::transparent: return "transparent";
+        case page_backing::normal: return "normal";
+        default: return "none";
+    }
+}
+
+/*
+ * Anonymous memory region for pools that take one, e.g.
+ *
+ *     page_region region(256 << 20);
+ *     tlsf_allocator<char> heap(region.data(), region.size());
+ *
+ * Mapping tries MAP_HUGETLB first, then a huge page aligned normal mapping
+ * with madvise(MADV_HUGEPAGE), then plain pages; `prefer` skips the tiers
+ * above it. backing() reports the tier that succeeded. With THP the kernel
+ * may still use base pages for parts of the region, huge_bytes() tells
+ * how much is actually on huge pages.
+ *
+ * With `prefault` every page is touched up front, so walking the pool
+ * later takes no page faults.
+ */
+class page_region {
+    public:
+        static constexpr size_t huge_page = size_t(2) << 20;
+    public:
+        explicit page_region(size_t bytes, bool prefault = false,
+                page_backing prefer = page_backing::hugetlb)
+            : base(nullptr), length(0), kind(page_backing::none) {
+            if(bytes == 0) {
+                return;
+            }
+            size_t rounded = (bytes + huge_page - 1) & ~(huge_page - 1);
+            if(prefer == page_backing::hugetlb && this->map_hugetlb(rounded, prefault)) {
+                return;
+            }
+            if(prefer != page_backing::normal && this->map_transparent(rounded)) {
+                this->kind = page_backing::transparent;
+            } else if(!this->map_normal(bytes)) {
+                return;
+            }
+            if(prefault) {
+                this->touch();
+            }
+        }
+        page_region(const page_region &) = delete;
+        page_region(const page_region &&) = delete;
+        ~page_region() {
+            if(this->base != nullptr) {
+                munmap(this->base, this->length);
+            }
+        }
+    public:
+        auto data() const -> void * {
+            return this->base;
+        }
+
+        auto size() const -> size_t {
+            return this->length;
+        }
+
+        auto backing() const -> page_backing {
+            return this->kind;
+        }
+
+        // Bytes of the region currently on huge pages, from the kernel's
+        // AnonHugePages count for the mapping (hugetlb: all of it).
+        auto huge_bytes() const -> size_t {
+            if(this->kind == page_backing::hugetlb) {
+                return this->length;
+            }
+            if(this->kind != page_backing::transparent) {
+                return 0;
+            }
+            FILE *f = fopen("/proc/self/smaps", "r");
+            if(f == nullptr) {
+                return 0;
+            }
+            char line[256];
+            bool inside = false;
+            size_t kb = 0;
+            auto begin = reinterpret_cast<uintptr_t>(this->base);
+            while(fgets(line, sizeof(line), f) != nullptr) {
+                unsigned long lo, hi;
+                if(sscanf(line, "%lx-%lx ", &lo, &hi) == 2) {
+                    inside = lo <= begin && begin < hi;
+                } else if(inside && strncmp(line, "AnonHugePages:", 14) == 0) {
+                    kb = strtoul(line + 14, nullptr, 10);
+                    break;
+                }
+            }
+            fclose(f);
+            return kb * 1024;
+        }
+
+    private:
+        auto map_hugetlb(size_t bytes, bool prefault) -> bool {
+            int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (prefault ? MAP_POPULATE : 0);
+            void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+            if(p == MAP_FAILED) {
+                return false;
+            }
+            this->base = p;
+            this->length = bytes;
+            this->kind = page_backing::hugetlb;
+            return true;
+        }
+
+        // Over-maps by one huge page and trims, so the region starts on a
+        // huge page boundary and every 2 MiB of it can be a huge page.
+        auto map_transparent(size_t bytes) -> bool {
+            size_t padded = bytes + huge_page;
+            void *p = mmap(nullptr, padded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if(p == MAP_FAILED) {
+                return false;
+            }
+            auto raw = reinterpret_cast<uintptr_t>(p);
+            auto aligned = (raw + huge_page - 1) & ~(uintptr_t)(huge_page - 1);
+            if(aligned > raw) {
+                munmap(p, aligned - raw);
+            }
+            if(raw + padded > aligned + bytes) {
+                munmap(reinterpret_cast<void *>(aligned + bytes), raw + padded - aligned - bytes);
+            }
+            this->base = reinterpret_cast<void *>(aligned);
+            this->length = bytes;
+            if(madvise(this->base, bytes, MADV_HUGEPAGE) != 0) {
+                return false;
+            }
+            return true;
+        }
+
+        auto map_normal(size_t bytes) -> bool {
+            if(this->base == nullptr) {
+                void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if(p == MAP_FAILED) {
+                    return false;
+                }
+                this->base = p;
+                this->length = bytes;
+            }
+            this->kind = page_backing::normal;
+            return true;
+        }
+
+        auto touch() -> void {
+            auto p = static_cast<volatile unsigned char *>(this->base);
+            size_t step = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            for(size_t off = 0; off < this->length; off += step) {
+                p[off] = 0;
+            }
+        }
+
+    private:
+        void *base;
+        size_t length;
+        page_backing kind;
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* PAGE_REGION_H_ */
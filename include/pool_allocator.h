@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Standard allocator and memory_resource adapters for kcore pools.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef POOL_ALLOCATOR_H_
+#define POOL_ALLOCATOR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/allocator.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <new>
+
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define KCORE_HAS_MEMORY_RESOURCE
+#endif
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+template<class Pool>
+concept bool any_allocator = KCORE_NAMESPACE::allocator<Pool> || array_allocator<Pool>;
+
+template<any_allocator Pool>
+auto pool_release(Pool &pool, void *p, size_t bytes) -> void {
+    using V = typename Pool::value_type;
+    if constexpr (array_allocator<Pool>) {
+        pool.deallocate(static_cast<V *>(p), (bytes + sizeof(V) - 1) / sizeof(V));
+    } else {
+        pool.deallocate(static_cast<V *>(p));
+    }
+}
+
+/*
+ * Carves `bytes` aligned to `align` out of a kcore pool, or returns null.
+ * Array pools are asked for enough value_type units to cover the bytes;
+ * single-object pools can only serve requests that fit one slot.
+ */
+template<any_allocator Pool>
+auto pool_acquire(Pool &pool, size_t bytes, size_t align) -> void * {
+    using V = typename Pool::value_type;
+    void *p = nullptr;
+    if constexpr (array_allocator<Pool>) {
+        p = pool.allocate((bytes + sizeof(V) - 1) / sizeof(V));
+    } else {
+        if(bytes <= sizeof(V) && align <= alignof(V)) {
+            p = pool.allocate();
+        }
+    }
+    if(p != nullptr && reinterpret_cast<uintptr_t>(p) % align != 0) {
+        pool_release(pool, p, bytes);
+        p = nullptr;
+    }
+    return p;
+}
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * Standard Allocator drawing from a kcore pool, for std containers:
+ *
+ *     tlsf_allocator<char> heap(region, size);
+ *     std::vector<int, pool_allocator<int, tlsf_allocator<char>>> v(heap);
+ *
+ * It holds nothing but a pointer to the pool, and rebinds freely so node
+ * based containers can allocate their nodes from the same pool. Pools
+ * modelling array_allocator serve any size; single-object pools serve
+ * only requests that fit one of their slots, which suits node containers
+ * such as std::list whose node fits the slot. A request the pool cannot
+ * serve throws std::bad_alloc, as allocator_traits expects.
+ */
+template<class T, KCORE_INNER_NAMESPACE::any_allocator Pool>
+class pool_allocator {
+    public:
+        using value_type = T;
+
+        template<class U>
+        struct rebind {
+            using other = pool_allocator<U, Pool>;
+        };
+    public:
+        pool_allocator(Pool &pool) noexcept : pool(&pool) {}
+
+        template<class U>
+        pool_allocator(const pool_allocator<U, Pool> &other) noexcept : pool(&other.upstream()) {}
+    public:
+        auto allocate(size_t n) -> T* {
+            void *p = KCORE_INNER_NAMESPACE::pool_acquire(*this->pool, n * sizeof(T), alignof(T));
+            if(p == nullptr) {
+                throw std::bad_alloc();
+            }
+            return static_cast<T *>(p);
+        }
+
+        auto deallocate(T *p, size_t n) noexcept -> void {
+            KCORE_INNER_NAMESPACE::pool_release(*this->pool, p, n * sizeof(T));
+        }
+
+        auto upstream() const noexcept -> Pool & {
+            return *this->pool;
+        }
+
+    private:
+        Pool *pool;
+};
+
+template<class T1, class T2, class Pool>
+constexpr bool operator==( const pool_allocator<T1, Pool>& lhs, const pool_allocator<T2, Pool>& rhs ) {
+    return &lhs.upstream() == &rhs.upstream();
+}
+
+template<class T1, class T2, class Pool>
+constexpr bool operator!=( const pool_allocator<T1, Pool>& lhs, const pool_allocator<T2, Pool>& rhs ) {
+    return &lhs.upstream() != &rhs.upstream();
+}
+
+#if defined(KCORE_HAS_MEMORY_RESOURCE)
+
+/*
+ * std::pmr::memory_resource over a kcore pool, for std::pmr containers.
+ * Same serving rules as pool_allocator, at the cost of a virtual call.
+ */
+template<KCORE_INNER_NAMESPACE::any_allocator Pool>
+class pool_resource : public std::pmr::memory_resource {
+    public:
+        explicit pool_resource(Pool &pool) noexcept : pool(&pool) {}
+
+        auto upstream() const noexcept -> Pool & {
+            return *this->pool;
+        }
+
+    protected:
+        auto do_allocate(size_t bytes, size_t align) -> void * override {
+            void *p = KCORE_INNER_NAMESPACE::pool_acquire(*this->pool, bytes, align);
+            if(p == nullptr) {
+                throw std::bad_alloc();
+            }
+            return p;
+        }
+
+        auto do_deallocate(void *p, size_t bytes, size_t) -> void override {
+            KCORE_INNER_NAMESPACE::pool_release(*this->pool, p, bytes);
+        }
+
+        auto do_is_equal(const std::pmr::memory_resource &other) const noexcept -> bool override {
+            auto same = dynamic_cast<const pool_resource *>(&other);
+            return same != nullptr && same->pool == this->pool;
+        }
+
+    private:
+        Pool *pool;
+};
+
+#endif
+
+}
+
+#endif /* POOL_ALLOCATOR_H_ */
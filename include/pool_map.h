@@ -0,0 +1,299 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Process-wide map from addresses to the pools that own them.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef POOL_MAP_H_
+#define POOL_MAP_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "size_class_allocator.h"
+#include "stl/stddef.h"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * One registered address range: [begin, end) belongs to `pool`, holds
+ * objects of `object_size` bytes and is freed through `release`.
+ */
+struct pool_entry {
+    void *pool;
+    size_t object_size;
+    int (*release)(pool_entry &e, void *p);
+    uintptr_t begin;
+    uintptr_t end;
+    // Ranges that share their first or last page with others are chained
+    // per page: links[0] continues the chain of the first page, links[1]
+    // that of the last one.
+    std::atomic<pool_entry *> links[2];
+};
+
+/*
+ * Radix tree from page number to pool_entry, covering 48-bit addresses
+ * with three levels of 4096 entries. Interior pages of a range map
+ * straight to its entry; the pages at either end may be shared with
+ * neighbouring ranges and hold a short chain instead. Lookups are
+ * lock-free; enter() and erase() serialize on a mutex and never free
+ * tree nodes.
+ */
+class pool_map {
+    private:
+        static constexpr int page_log2 = 12;
+        static constexpr int level_bits = 12;
+        static constexpr size_t fanout = size_t(1) << level_bits;
+        static constexpr uintptr_t level_mask = fanout - 1;
+
+        struct leaf {
+            std::atomic<pool_entry *> pages[fanout];
+        };
+
+        struct middle {
+            std::atomic<leaf *> leaves[fanout];
+        };
+    public:
+        // Maps [begin, end) to e until erase(e). Fails if the tree cannot
+        // grow, leaving e unregistered.
+        static auto enter(pool_entry &e, const void *begin, const void *end) -> bool {
+            std::lock_guard<std::mutex> guard(lock());
+            e.begin = reinterpret_cast<uintptr_t>(begin);
+            e.end = reinterpret_cast<uintptr_t>(end);
+            e.links[0].store(nullptr, std::memory_order_relaxed);
+            e.links[1].store(nullptr, std::memory_order_relaxed);
+            uintptr_t first = e.begin >> page_log2;
+            uintptr_t last = (e.end - 1) >> page_log2;
+            for(uintptr_t page = first; page <= last; ++page) {
+                if(slot_of(page, true) == nullptr) {
+                    e.end = e.begin;
+                    return false;
+                }
+            }
+            for(uintptr_t page = first + 1; page < last; ++page) {
+                slot_of(page, false)->store(&e, std::memory_order_release);
+            }
+            push(first, e, 0);
+            if(last != first) {
+                push(last, e, 1);
+            }
+            return true;
+        }
+
+        static auto erase(pool_entry &e) -> void {
+            std::lock_guard<std::mutex> guard(lock());
+            if(e.begin == e.end) {
+                return;
+            }
+            uintptr_t first = e.begin >> page_log2;
+            uintptr_t last = (e.end - 1) >> page_log2;
+            for(uintptr_t page = first + 1; page < last; ++page) {
+                slot_of(page, false)->store(nullptr, std::memory_order_release);
+            }
+            unlink(first, e);
+            if(last != first) {
+                unlink(last, e);
+            }
+        }
+
+        // Entry whose range contains p, or nullptr.
+        static auto find(const void *p) -> pool_entry * {
+            auto addr = reinterpret_cast<uintptr_t>(p);
+            uintptr_t page = addr >> page_log2;
+            auto slot = slot_of(page, false);
+            if(slot == nullptr) {
+                return nullptr;
+            }
+            pool_entry *e = slot->load(std::memory_order_acquire);
+            while(e != nullptr && (addr < e->begin || addr >= e->end)) {
+                e = next_on(page, e)->load(std::memory_order_acquire);
+            }
+            return e;
+        }
+
+    private:
+        static auto next_on(uintptr_t page, pool_entry *e) -> std::atomic<pool_entry *> * {
+            return &e->links[page == (e->begin >> page_log2) ? 0 : 1];
+        }
+
+        static auto push(uintptr_t page, pool_entry &e, int link) -> void {
+            auto slot = slot_of(page, false);
+            e.links[link].store(slot->load(std::memory_order_relaxed), std::memory_order_relaxed);
+            slot->store(&e, std::memory_order_release);
+        }
+
+        static auto unlink(uintptr_t page, pool_entry &e) -> void {
+            std::atomic<pool_entry *> *link = slot_of(page, false);
+            pool_entry *cur = link->load(std::memory_order_relaxed);
+            while(cur != &e) {
+                link = next_on(page, cur);
+                cur = link->load(std::memory_order_relaxed);
+            }
+            link->store(next_on(page, &e)->load(std::memory_order_relaxed), std::memory_order_release);
+        }
+
+        // The page's slot, creating missing tree nodes if `grow` is set.
+        static auto slot_of(uintptr_t page, bool grow) -> std::atomic<pool_entry *> * {
+            size_t top = (page >> (2 * level_bits)) & level_mask;
+            size_t mid = (page >> level_bits) & level_mask;
+            if((page >> (3 * level_bits)) != 0) {
+                return nullptr;
+            }
+            middle *m = root()[top].load(std::memory_order_acquire);
+            if(m == nullptr) {
+                if(!grow || (m = make<middle>()) == nullptr) {
+                    return nullptr;
+                }
+                root()[top].store(m, std::memory_order_release);
+            }
+            leaf *l = m->leaves[mid].load(std::memory_order_acquire);
+            if(l == nullptr) {
+                if(!grow || (l = make<leaf>()) == nullptr) {
+                    return nullptr;
+                }
+                m->leaves[mid].store(l, std::memory_order_release);
+            }
+            return &l->pages[page & level_mask];
+        }
+
+        template<class Node>
+        static auto make() -> Node * {
+            return new (std::nothrow) Node{};
+        }
+
+        static auto root() -> std::atomic<middle *> * {
+            static std::atomic<middle *> nodes[fanout];
+            return nodes;
+        }
+
+        static auto lock() -> std::mutex & {
+            static std::mutex m;
+            return m;
+        }
+};
+
+/*
+ * Alloc whose storage is entered into pool_map for as long as it lives,
+ * constructed from Alloc's own arguments:
+ *
+ *     registered<typed_allocator<msg, 64>> msgs;
+ *
+ * The range registered is the pool object itself, which is where pools
+ * with inline slots (typed_allocator, bitmap_allocator, ...) keep them.
+ */
+template<class Alloc>
+class registered : public Alloc {
+    public:
+        using value_type = typename Alloc::value_type;
+    public:
+        template<class... Args>
+        explicit registered(Args&&... args) : Alloc(std::forward<Args>(args)...) {
+            Alloc *base = this;
+            this->entry.pool = base;
+            this->entry.object_size = sizeof(value_type);
+            this->entry.release = [](pool_entry &e, void *p) -> int {
+                return static_cast<Alloc *>(e.pool)->deallocate(static_cast<value_type *>(p));
+            };
+            auto begin = reinterpret_cast<const unsigned char *>(base);
+            pool_map::enter(this->entry, begin, begin + sizeof(Alloc));
+        }
+        registered(const registered &) = delete;
+        registered(const registered &&) = delete;
+        ~registered() {
+            pool_map::erase(this->entry);
+        }
+
+    private:
+        pool_entry entry;
+};
+
+// A size_class_allocator enters each slab on its own, so a lookup also
+// yields the size class and freeing goes straight to that slab.
+template<class Tp, int... Counts>
+class registered<size_class_allocator<Tp, Counts...>> : public size_class_allocator<Tp, Counts...> {
+    private:
+        using base_type = size_class_allocator<Tp, Counts...>;
+    public:
+        using value_type = Tp;
+    public:
+        registered() {
+            base_type *base = this;
+            for(int i = 0; i < base_type::classes; ++i) {
+                auto bounds = base->slab_bounds(i);
+                this->entries[i].pool = base;
+                this->entries[i].object_size = base_type::min_size << i;
+                this->entries[i].release = [](pool_entry &e, void *p) -> int {
+                    static_cast<base_type *>(e.pool)->deallocate(
+                        static_cast<Tp *>(p), e.object_size / sizeof(Tp));
+                    return 0;
+                };
+                pool_map::enter(this->entries[i], bounds.first, bounds.second);
+            }
+        }
+        registered(const registered &) = delete;
+        registered(const registered &&) = delete;
+        ~registered() {
+            for(int i = 0; i < base_type::classes; ++i) {
+                pool_map::erase(this->entries[i]);
+            }
+        }
+
+    private:
+        pool_entry entries[base_type::classes];
+};
+
+// Frees p into whichever registered pool owns it; -1 if none does.
+inline auto deallocate(void *p) -> int {
+    pool_entry *e = pool_map::find(p);
+    return e == nullptr ? -1 : e->release(*e, p);
+}
+
+// Object size, or size class block size, of the registered pool owning
+// p; 0 if none does.
+inline auto object_size(const void *p) -> size_t {
+    pool_entry *e = pool_map::find(p);
+    return e == nullptr ? 0 : e->object_size;
+}
+
+} /* KCORE_NAMESPACE */
+
+#endif /* POOL_MAP_H_ */
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Owning handles to objects constructed in kcore pools.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef POOL_PTR_H_
+#define POOL_PTR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+#include <cstdlib>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+template<class T, class Pool>
+concept bool holds = allocator<Pool> &&
+    sizeof(T) <= sizeof(typename Pool::value_type) &&
+    alignof(T) <= alignof(typename Pool::value_type);
+
+// Constructs a T in a fresh slot of `pool`; null if the pool is exhausted.
+template<class T, class Pool, class... Args>
+auto pool_construct(Pool &pool, Args&&... args) -> T * {
+    void *slot = pool.allocate();
+    if(slot == nullptr) {
+        return nullptr;
+    }
+#if defined(__cpp_exceptions)
+    try {
+        return ::new (slot) T(std::forward<Args>(args)...);
+    } catch(...) {
+        pool.deallocate(static_cast<typename Pool::value_type *>(slot));
+        throw;
+    }
+#else
+    return ::new (slot) T(std::forward<Args>(args)...);
+#endif
+}
+
+template<class T, class Pool>
+auto pool_destroy(Pool &pool, T *p) -> void {
+    p->~T();
+    pool.deallocate(reinterpret_cast<typename Pool::value_type *>(p));
+}
+
+} /* KCORE_INNER_NAMESPACE */
+
+// Returns objects to a pool known at run time; one pointer wide.
+template<class Pool>
+class pool_deleter {
+    public:
+        pool_deleter(Pool *pool = nullptr) noexcept : pool(pool) {}
+
+        template<class T>
+        auto operator()(T *p) const -> void {
+            KCORE_INNER_NAMESPACE::pool_destroy(*this->pool, p);
+        }
+
+        auto upstream() const noexcept -> Pool * {
+            return this->pool;
+        }
+
+    private:
+        Pool *pool;
+};
+
+// Returns objects to a pool with static storage duration; empty.
+template<auto &Pool>
+class static_pool_deleter {
+    public:
+        template<class T>
+        auto operator()(T *p) const -> void {
+            KCORE_INNER_NAMESPACE::pool_destroy(Pool, p);
+        }
+
+        auto upstream() const noexcept -> decltype(&Pool) {
+            return &Pool;
+        }
+};
+
+/*
+ * Move-only owner of a T living in a pool slot. Destroying or resetting
+ * it runs ~T() and hands the slot back. The deleter is an empty base
+ * when the pool is static, so such a pool_ptr is exactly one pointer.
+ */
+template<class T, class Deleter>
+class pool_ptr : private Deleter {
+    public:
+        using element_type = T;
+        using deleter_type = Deleter;
+    public:
+        constexpr pool_ptr() noexcept : Deleter(), ptr(nullptr) {}
+        constexpr pool_ptr(decltype(nullptr)) noexcept : Deleter(), ptr(nullptr) {}
+        pool_ptr(T *p, Deleter d) noexcept : Deleter(d), ptr(p) {}
+        explicit pool_ptr(T *p) noexcept : Deleter(), ptr(p) {}
+        pool_ptr(const pool_ptr &) = delete;
+        pool_ptr(pool_ptr &&other) noexcept : Deleter(other.get_deleter()), ptr(other.release()) {}
+        ~pool_ptr() {
+            this->reset();
+        }
+
+        auto operator=(const pool_ptr &) -> pool_ptr & = delete;
+        auto operator=(pool_ptr &&other) noexcept -> pool_ptr & {
+            if(this != &other) {
+                this->reset();
+                static_cast<Deleter &>(*this) = other.get_deleter();
+                this->ptr = other.release();
+            }
+            return *this;
+        }
+    public:
+        auto get() const noexcept -> T * {
+            return this->ptr;
+        }
+
+        auto operator*() const -> T & {
+            return *this->ptr;
+        }
+
+        auto operator->() const noexcept -> T * {
+            return this->ptr;
+        }
+
+        explicit operator bool() const noexcept {
+            return this->ptr != nullptr;
+        }
+
+        auto get_deleter() const noexcept -> const Deleter & {
+            return *this;
+        }
+
+        // Gives up ownership without destroying the object.
+        auto release() noexcept -> T * {
+            T *p = this->ptr;
+            this->ptr = nullptr;
+            return p;
+        }
+
+        auto reset() -> void {
+            if(this->ptr != nullptr) {
+                T *p = this->release();
+                static_cast<Deleter &>(*this)(p);
+            }
+        }
+
+    private:
+        T *ptr;
+};
+
+template<class T1, class D1, class T2, class D2>
+bool operator==( const pool_ptr<T1, D1>& lhs, const pool_ptr<T2, D2>& rhs ) {
+    return lhs.get() == rhs.get();
+}
+
+template<class T1, class D1, class T2, class D2>
+bool operator!=( const pool_ptr<T1, D1>& lhs, const pool_ptr<T2, D2>& rhs ) {
+    return lhs.get() != rhs.get();
+}
+
+/*
+ * Constructs a T in `pool` and returns its owner, or an empty pool_ptr
+ * when the pool is exhausted:
+ *
+ *     auto frame = make_pooled<sensor_frame>(frames, id, now);
+ *
+ * The handle remembers the pool it came from.
+ */
+template<class T, class Pool, class... Args>
+    requires KCORE_INNER_NAMESPACE::holds<T, Pool>
+auto make_pooled(Pool &pool, Args&&... args) -> pool_ptr<T, pool_deleter<Pool>> {
+    T *p = KCORE_INNER_NAMESPACE::pool_construct<T>(pool, std::forward<Args>(args)...);
+    return pool_ptr<T, pool_deleter<Pool>>(p, pool_deleter<Pool>(&pool));
+}
+
+/*
+ * Same for a pool with static storage duration, named as a template
+ * argument; the handle stores no pool pointer:
+ *
+ *     static typed_allocator<sensor_frame, 64> frames;
+ *     auto frame = make_pooled<sensor_frame, frames>(id, now);
+ */
+template<class T, auto &Pool, class... Args>
+    requires KCORE_INNER_NAMESPACE::holds<T, std::remove_reference_t<decltype(Pool)>>
+auto make_pooled(Args&&... args) -> pool_ptr<T, static_pool_deleter<Pool>> {
+    T *p = KCORE_INNER_NAMESPACE::pool_construct<T>(Pool, std::forward<Args>(args)...);
+    return pool_ptr<T, static_pool_deleter<Pool>>(p);
+}
+
+/*
+ * Shared owner of a T living in the slot of a shared_allocator. The
+ * reference count is the pool's own per-slot count, so there is no
+ * control block: a handle is the object pointer plus its Deleter, which
+ * is empty for a static pool. The last handle to go runs ~T() and
+ * returns the slot. Counts are atomic when the pool is
+ * concurrent_allocator and plain with typed_allocator.
+ *
+ * The per-slot count saturates at the limit of the pool's Count type,
+ * a byte by default; give the pool a wider Count for objects with many
+ * owners. A copy cannot report failure, so copying a handle whose count
+ * is saturated aborts.
+ */
+template<class T, class Deleter>
+class pool_shared_ptr : private Deleter {
+    public:
+        using element_type = T;
+        using deleter_type = Deleter;
+    public:
+        constexpr pool_shared_ptr() noexcept : Deleter(), ptr(nullptr) {}
+        constexpr pool_shared_ptr(decltype(nullptr)) noexcept : Deleter(), ptr(nullptr) {}
+        // Adopts the reference already held on p, e.g. the one allocate()
+        // hands out.
+        pool_shared_ptr(T *p, Deleter d) noexcept : Deleter(d), ptr(p) {}
+        explicit pool_shared_ptr(T *p) noexcept : Deleter(), ptr(p) {}
+        pool_shared_ptr(const pool_shared_ptr &other) : Deleter(other.get_deleter()), ptr(nullptr) {
+            this->ptr = other.share();
+        }
+        pool_shared_ptr(pool_shared_ptr &&other) noexcept : Deleter(other.get_deleter()), ptr(other.ptr) {
+            other.ptr = nullptr;
+        }
+        ~pool_shared_ptr() {
+            this->reset();
+        }
+
+        auto operator=(const pool_shared_ptr &other) -> pool_shared_ptr & {
+            if(this != &other) {
+                T *p = other.share();
+                this->reset();
+                static_cast<Deleter &>(*this) = other.get_deleter();
+                this->ptr = p;
+            }
+            return *this;
+        }
+        auto operator=(pool_shared_ptr &&other) noexcept -> pool_shared_ptr & {
+            if(this != &other) {
+                this->reset();
+                static_cast<Deleter &>(*this) = other.get_deleter();
+                this->ptr = other.ptr;
+                other.ptr = nullptr;
+            }
+            return *this;
+        }
+    public:
+        auto get() const noexcept -> T * {
+            return this->ptr;
+        }
+
+        auto operator*() const -> T & {
+            return *this->ptr;
+        }
+
+        auto operator->() const noexcept -> T * {
+            return this->ptr;
+        }
+
+        explicit operator bool() const noexcept {
+            return this->ptr != nullptr;
+        }
+
+        auto get_deleter() const noexcept -> const Deleter & {
+            return *this;
+        }
+
+        auto reset() -> void {
+            if(this->ptr != nullptr) {
+                T *p = this->ptr;
+                this->ptr = nullptr;
+                auto &pool = *this->get_deleter().upstream();
+                using slot_type = typename std::remove_reference_t<decltype(pool)>::value_type;
+                pool.release(reinterpret_cast<slot_type *>(p), [](slot_type *s) {
+                    reinterpret_cast<T *>(s)->~T();
+                });
+            }
+        }
+
+    private:
+        auto share() const -> T * {
+            if(this->ptr == nullptr) {
+                return nullptr;
+            }
+            auto &pool = *this->get_deleter().upstream();
+            using slot_type = typename std::remove_reference_t<decltype(pool)>::value_type;
+            if(pool.retain(reinterpret_cast<slot_type *>(this->ptr)) < 0) {
+                abort();
+            }
+            return this->ptr;
+        }
+
+    private:
+        T *ptr;
+};
+
+template<class T1, class D1, class T2, class D2>
+bool operator==( const pool_shared_ptr<T1, D1>& lhs, const pool_shared_ptr<T2, D2>& rhs ) {
+    return lhs.get() == rhs.get();
+}
+
+template<class T1, class D1, class T2, class D2>
+bool operator!=( const pool_shared_ptr<T1, D1>& lhs, const pool_shared_ptr<T2, D2>& rhs ) {
+    return lhs.get() != rhs.get();
+}
+
+// make_pooled counterparts returning shared handles.
+template<class T, shared_allocator Pool, class... Args>
+    requires KCORE_INNER_NAMESPACE::holds<T, Pool>
+auto make_shared_pooled(Pool &pool, Args&&... args) -> pool_shared_ptr<T, pool_deleter<Pool>> {
+    T *p = KCORE_INNER_NAMESPACE::pool_construct<T>(pool, std::forward<Args>(args)...);
+    return pool_shared_ptr<T, pool_deleter<Pool>>(p, pool_deleter<Pool>(&pool));
+}
+
+template<class T, auto &Pool, class... Args>
+    requires KCORE_INNER_NAMESPACE::holds<T, std::remove_reference_t<decltype(Pool)>> &&
+        shared_allocator<std::remove_reference_t<decltype(Pool)>>
+auto make_shared_pooled(Args&&... args) -> pool_shared_ptr<T, static_pool_deleter<Pool>> {
+    T *p = KCORE_INNER_NAMESPACE::pool_construct<T>(Pool, std::forward<Args>(args)...);
+    return pool_shared_ptr<T, static_pool_deleter<Pool>>(p);
+}
+
+} /* KCORE_NAMESPACE */
+
+#endif /* POOL_PTR_H_ */
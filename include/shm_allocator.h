@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Lock-free typed allocator in shared memory.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef SHM_ALLOCATOR_H_
+#define SHM_ALLOCATOR_H_
+
+#include "constants.h"
+#include "concurrent_allocator.h"
+#include "stl/stddef.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * concurrent_allocator placed in a shared memory segment, so that several
+ * processes can allocate from and free into the same pool. The pool holds
+ * no pointers (its free list links and head are slot indices), so each
+ * process may map the segment at a different address. Objects are passed
+ * between processes as offsets from the segment base, see offset_of()
+ * and at().
+ *
+ * The segment is a POSIX shared memory object opened by name, or any
+ * descriptor that can be mapped, e.g. from memfd_create() shared through
+ * fork() or SCM_RIGHTS. Whichever process maps it first initializes the
+ * pool; the others wait until it is ready, and take over if that process
+ * dies first. All of them must share a pid namespace for this. Objects
+ * must not hold pointers either, since they are mapped at different
+ * addresses as well.
+ *
+ * The builder stamps the segment with a header describing the pool. A
+ * process whose shm_allocator has a different Tp, N or layout refuses to
+ * map such a segment, and is_open() stays false.
+ */
+template<class Tp, int N>
+class shm_allocator {
+    static_assert(std::is_trivially_copyable_v<Tp>,
+        "shm_allocator objects are shared byte for byte between processes");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free,
+        "shm_allocator needs address-free 64-bit atomics");
+    private:
+        // Any other state is the pid of the process building the pool.
+        static constexpr uint32_t blank = 0;
+        static constexpr uint32_t ready = UINT32_MAX;
+
+        static constexpr uint64_t magic = 0x6b636f72652d7368ULL; // "kcore-sh"
+        static constexpr uint32_t version = 1;
+
+        using pool_type = concurrent_allocator<Tp, N>;
+
+        struct header {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t slot_size;
+            uint64_t capacity;
+            uint64_t segment_size;
+        };
+
+        struct segment {
+            std::atomic<uint32_t> state;    // zero-filled when created
+            header head;
+            pool_type pool;
+        };
+    public:
+        using value_type = Tp;
+    public:
+        // Opens the shared memory object `name`, creating it if needed.
+        explicit shm_allocator(const char *name) : seg(nullptr) {
+            int fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+            if(fd >= 0) {
+                this->attach(fd);
+                close(fd);
+            }
+        }
+        // Maps the segment behind `fd`, which stays owned by the caller.
+        explicit shm_allocator(int fd) : seg(nullptr) {
+            this->attach(fd);
+        }
+        shm_allocator(const shm_allocator &) = delete;
+        shm_allocator(const shm_allocator &&) = delete;
+        ~shm_allocator() {
+            if(this->seg != nullptr) {
+                munmap(this->seg, sizeof(segment));
+            }
+        }
+    public:
+        // impl allocator
+        auto allocate() -> Tp* {
+            return this->seg == nullptr ? nullptr : this->seg->pool.allocate();
+        }
+
+        auto deallocate(Tp *p) -> int {
+            return this->seg == nullptr ? -1 : this->seg->pool.deallocate(p);
+        }
+
+    public:
+        // impl batch_allocator
+        auto allocate_n(Tp **out, size_t n) -> size_t {
+            return this->seg == nullptr ? 0 : this->seg->pool.allocate_n(out, n);
+        }
+
+        auto deallocate_n(Tp **in, size_t n) -> size_t {
+            return this->seg == nullptr ? 0 : this->seg->pool.deallocate_n(in, n);
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() const -> size_t {
+            return this->seg == nullptr ? 0 : this->seg->pool.available_count();
+        }
+
+        auto has(Tp *ptr) const -> bool {
+            return this->seg != nullptr && this->seg->pool.has(ptr);
+        }
+
+    public:
+        auto is_open() const -> bool {
+            return this->seg != nullptr;
+        }
+
+        // Process-independent name of an object, and back.
+        auto offset_of(const Tp *p) const -> uint64_t {
+            return reinterpret_cast<const unsigned char *>(p) -
+                reinterpret_cast<const unsigned char *>(this->seg);
+        }
+
+        auto at(uint64_t offset) const -> Tp * {
+            return reinterpret_cast<Tp *>(reinterpret_cast<unsigned char *>(this->seg) + offset);
+        }
+
+        // Removes the name; processes that have the segment mapped keep it.
+        static auto remove(const char *name) -> bool {
+            return shm_unlink(name) == 0;
+        }
+
+    private:
+        auto attach(int fd) -> void {
+            struct stat st;
+            if(fstat(fd, &st) != 0) {
+                return;
+            }
+            if(static_cast<size_t>(st.st_size) < sizeof(segment) && ftruncate(fd, sizeof(segment)) != 0) {
+                return;
+            }
+            void *addr = mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if(addr == MAP_FAILED) {
+                return;
+            }
+            auto s = static_cast<segment *>(addr);
+            const uint32_t self = static_cast<uint32_t>(getpid());
+            uint32_t state = s->state.load(std::memory_order_acquire);
+            while(state != ready) {
+                if(state == blank || !alive(state)) {
+                    // Build it, or rebuild what a dead builder left behind.
+                    if(s->state.compare_exchange_strong(state, self, std::memory_order_acquire)) {
+                        ::new (&s->pool) pool_type();
+                        format(s->head);
+                        s->state.store(ready, std::memory_order_release);
+                        break;
+                    }
+                    continue;
+                }
+                sched_yield();
+                state = s->state.load(std::memory_order_acquire);
+            }
+            if(!valid(s->head)) {
+                munmap(addr, sizeof(segment));
+                return;
+            }
+            this->seg = s;
+        }
+
+        static auto format(header &h) -> void {
+            h.magic = magic;
+            h.version = version;
+            h.slot_size = sizeof(Tp);
+            h.capacity = N;
+            h.segment_size = sizeof(segment);
+        }
+
+        static auto valid(const header &h) -> bool {
+            return h.magic == magic && h.version == version &&
+                h.slot_size == sizeof(Tp) && h.capacity == N &&
+                h.segment_size == sizeof(segment);
+        }
+
+        // Whether process `pid` can still finish building; a zombie cannot.
+        static auto alive(uint32_t pid) -> bool {
+            if(kill(static_cast<pid_t>(pid), 0) != 0 && errno == ESRCH) {
+                return false;
+            }
+            char path[32];
+            snprintf(path, sizeof(path), "/proc/%u/stat", pid);
+            FILE *f = fopen(path, "r");
+            if(f == nullptr) {
+                return true;
+            }
+            // The state letter follows the parenthesized command name.
+            char buf[256];
+            size_t len = fread(buf, 1, sizeof(buf) - 1, f);
+            fclose(f);
+            buf[len] = '\0';
+            const char *close_paren = strrchr(buf, ')');
+            return close_paren == nullptr || close_paren[1] != ' ' || close_paren[2] != 'Z';
+        }
+
+    private:
+        segment *seg;
+};
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator==( const shm_allocator<T1, N1>& lhs, const shm_allocator<T2, N2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template< class T1, int N1, class T2, int N2>
+constexpr bool operator!=( const shm_allocator<T1, N1>& lhs, const shm_allocator<T2, N2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* SHM_ALLOCATOR_H_ */
@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Size-class slab allocator built from typed_allocator pools.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef SIZE_CLASS_ALLOCATOR_H_
+#define SIZE_CLASS_ALLOCATOR_H_
+
+#include "constants.h"
+#include "typed_allocator.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+// One slab slot of a size class.
+template<size_t Size>
+struct alignas(16) size_class_block {
+    unsigned char data[Size];
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+// Occupancy counters of a single size class.
+struct size_class_stats {
+    size_t block_size;  // bytes per block
+    size_t capacity;    // blocks in the slab
+    size_t in_use;      // blocks currently handed out
+    size_t peak;        // highest in_use seen
+    size_t requests;    // allocations whose size routed to this class
+    size_t spills;      // of those, served by a larger class
+    size_t failures;    // of those, not served at all
+};
+
+/*
+ * Variable-size allocator made of one typed_allocator slab per size class.
+ * Class i holds Counts[i] blocks of (MinSize << i) bytes; allocate(n) goes
+ * to the smallest class that fits n objects and spills to the next larger
+ * class when that slab is exhausted.
+ *
+ *     size_class_allocator<char, 64, 64, 32, 32, 16, 16, 8, 8, 4> heap;
+ *
+ * gives 16, 32, ..., 4096 byte classes.
+ */
+template<class Tp, int... Counts>
+class size_class_allocator {
+    static_assert(sizeof...(Counts) > 0, "size_class_allocator needs at least one class");
+    public:
+        static constexpr size_t min_size = 16;
+        static constexpr int classes = sizeof...(Counts);
+        static constexpr size_t max_size = min_size << (classes - 1);
+    private:
+        template<size_t... I>
+        static auto make_slabs(std::index_sequence<I...>) -> std::tuple<
+            typed_allocator<KCORE_INNER_NAMESPACE::size_class_block<(min_size << I)>, Counts>...>;
+
+        using slabs_type = decltype(make_slabs(std::make_index_sequence<classes>()));
+    public:
+        using value_type = Tp;
+    public:
+        size_class_allocator() : class_stats{} {
+            for(int i = 0; i < classes; ++i) {
+                this->class_stats[i].block_size = min_size << i;
+                this->class_stats[i].capacity = counts[i];
+            }
+        }
+        size_class_allocator(const size_class_allocator &) = delete;
+        size_class_allocator(const size_class_allocator &&) = delete;
+        ~size_class_allocator() = default;
+    public:
+        // impl array_allocator
+        auto allocate(size_t n) -> Tp* {
+            int wanted = class_of_n(n);
+            if(wanted >= classes) {
+                return nullptr;
+            }
+            ++(this->class_stats[wanted].requests);
+            for(int i = wanted; i < classes; ++i) {
+                void *p = this->visit(i, [](auto &slab) -> void * {
+                    return slab.allocate();
+                });
+                if(p != nullptr) {
+                    if(i != wanted) {
+                        ++(this->class_stats[wanted].spills);
+                    }
+                    auto &s = this->class_stats[i];
+                    if(++s.in_use > s.peak) {
+                        s.peak = s.in_use;
+                    }
+                    return static_cast<Tp *>(p);
+                }
+            }
+            ++(this->class_stats[wanted].failures);
+            return nullptr;
+        }
+
+        auto deallocate(Tp *p, size_t n) -> void {
+            // The block normally sits in the class n routes to, unless the
+            // allocation spilled upwards.
+            int wanted = class_of_n(n);
+            for(int i = wanted < classes ? wanted : 0; i < classes; ++i) {
+                if(this->release(i, p)) {
+                    return;
+                }
+            }
+            for(int i = 0; i < wanted && i < classes; ++i) {
+                if(this->release(i, p)) {
+                    return;
+                }
+            }
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() -> size_t {
+            size_t num_free = 0;
+            for(int i = 0; i < classes; ++i) {
+                num_free += this->class_stats[i].capacity - this->class_stats[i].in_use;
+            }
+            return num_free;
+        }
+
+        auto has(Tp *ptr) -> bool {
+            for(int i = 0; i < classes; ++i) {
+                if(this->owns(i, ptr)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+    public:
+        auto stats(int i) const -> const size_class_stats & {
+            return this->class_stats[i];
+        }
+
+        // Address range of class i's blocks.
+        auto slab_bounds(int i) -> std::pair<const void *, const void *> {
+            std::pair<const void *, const void *> bounds{nullptr, nullptr};
+            this->visit(i, [&bounds](auto &slab) -> void * {
+                auto begin = reinterpret_cast<const unsigned char *>(&slab);
+                bounds = {begin, begin + sizeof(slab)};
+                return nullptr;
+            });
+            return bounds;
+        }
+
+        // Index of the smallest class holding `bytes`, or `classes` when
+        // none does.
+        static constexpr auto class_of(size_t bytes) -> int {
+            int i = 0;
+            while(i < classes && (min_size << i) < bytes) {
+                ++i;
+            }
+            return i;
+        }
+
+    private:
+        // class_of() for n elements; `classes` when their size overflows.
+        static constexpr auto class_of_n(size_t n) -> int {
+            return n > SIZE_MAX / sizeof(Tp) ? classes : class_of(n * sizeof(Tp));
+        }
+
+        static constexpr int counts[classes] = { Counts... };
+
+        template<class F, size_t... I>
+        auto visit_impl(int i, F &&f, std::index_sequence<I...>) -> void * {
+            void *result = nullptr;
+            ((static_cast<int>(I) == i ? (result = f(std::get<I>(this->slabs)), 0) : 0), ...);
+            return result;
+        }
+
+        template<class F>
+        auto visit(int i, F &&f) -> void * {
+            return this->visit_impl(i, std::forward<F>(f), std::make_index_sequence<classes>());
+        }
+
+        auto owns(int i, Tp *ptr) -> bool {
+            return this->visit(i, [ptr](auto &slab) -> void * {
+                using block = typename std::remove_reference_t<decltype(slab)>::value_type;
+                return slab.has(reinterpret_cast<block *>(ptr)) ? ptr : nullptr;
+            }) != nullptr;
+        }
+
+        auto release(int i, Tp *ptr) -> bool {
+            bool freed = this->visit(i, [ptr](auto &slab) -> void * {
+                using block = typename std::remove_reference_t<decltype(slab)>::value_type;
+                auto b = reinterpret_cast<block *>(ptr);
+                return slab.has(b) && slab.deallocate(b) == 0 ? ptr : nullptr;
+            }) != nullptr;
+            if(freed) {
+                --(this->class_stats[i].in_use);
+            }
+            return freed;
+        }
+
+    private:
+        slabs_type slabs;
+        size_class_stats class_stats[classes];
+};
+
+template<class T1, int... C1, class T2, int... C2>
+constexpr bool operator==( const size_class_allocator<T1, C1...>& lhs, const size_class_allocator<T2, C2...>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class T1, int... C1, class T2, int... C2>
+constexpr bool operator!=( const size_class_allocator<T1, C1...>& lhs, const size_class_allocator<T2, C2...>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* SIZE_CLASS_ALLOCATOR_H_ */
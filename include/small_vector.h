@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Vector with inline storage that spills to an array_allocator.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef SMALL_VECTOR_H_
+#define SMALL_VECTOR_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "static_vector.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+/*
+ * Vector keeping up to N elements inline and moving them to a buffer
+ * from Alloc, an array_allocator, when it grows past that; the buffer
+ * doubles from then on. As with static_vector nothing throws: when Alloc
+ * runs out, push_back() returns false, emplace_back() and insert() return
+ * nullptr, reserve() and resize() return false, and the vector is left
+ * unchanged.
+ *
+ * Moving never allocates: a spilled buffer is handed over together with
+ * its allocator, inline elements are moved one by one. Copies allocate
+ * from the source's allocator when they do not fit inline, and come out
+ * empty if that fails.
+ */
+template<class T, size_t N, class Alloc>
+    requires array_allocator<Alloc>
+class small_vector {
+    static_assert(N > 0, "small_vector needs room for one inline element");
+    private:
+        using unit = typename Alloc::value_type;
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T *;
+        using const_iterator = const T *;
+    public:
+        explicit small_vector(Alloc &alloc)
+            : elems(this->inline_data()), count(0), limit(N), alloc(&alloc) {}
+        small_vector(const small_vector &other) : small_vector(*other.alloc) {
+            if(this->reserve(other.count)) {
+                KCORE_INNER_NAMESPACE::copy_into(this->elems, other.elems, other.count);
+                this->count = other.count;
+            }
+        }
+        small_vector(small_vector &&other)
+            : elems(this->inline_data()), count(0), limit(N), alloc(other.alloc) {
+            this->take(other);
+        }
+        ~small_vector() {
+            this->clear();
+            this->release();
+        }
+
+        auto operator=(const small_vector &other) -> small_vector & {
+            if(this != &other) {
+                this->clear();
+                if(this->reserve(other.count)) {
+                    KCORE_INNER_NAMESPACE::copy_into(this->elems, other.elems, other.count);
+                    this->count = other.count;
+                }
+            }
+            return *this;
+        }
+        auto operator=(small_vector &&other) -> small_vector & {
+            if(this != &other) {
+                this->clear();
+                this->release();
+                this->alloc = other.alloc;
+                this->take(other);
+            }
+            return *this;
+        }
+    public:
+        auto data() -> T * { return this->elems; }
+        auto data() const -> const T * { return this->elems; }
+        auto size() const -> size_t { return this->count; }
+        auto capacity() const -> size_t { return this->limit; }
+        auto empty() const -> bool { return this->count == 0; }
+
+        // Whether the elements are still in the inline buffer.
+        auto is_inline() const -> bool {
+            return this->elems == this->inline_data();
+        }
+
+        auto begin() -> iterator { return this->elems; }
+        auto end() -> iterator { return this->elems + this->count; }
+        auto begin() const -> const_iterator { return this->elems; }
+        auto end() const -> const_iterator { return this->elems + this->count; }
+
+        auto operator[](size_t i) -> T & { return this->elems[i]; }
+        auto operator[](size_t i) const -> const T & { return this->elems[i]; }
+        auto front() -> T & { return this->elems[0]; }
+        auto back() -> T & { return this->elems[this->count - 1]; }
+
+    public:
+        template<class... Args>
+        auto emplace_back(Args&&... args) -> T * {
+            if(this->count == this->limit) {
+                // args may refer to an element that growing moves away
+                T value(std::forward<Args>(args)...);
+                if(!this->reserve(this->limit * 2)) {
+                    return nullptr;
+                }
+                return this->emplace_back(std::move(value));
+            }
+            T *p = ::new (this->end()) T(std::forward<Args>(args)...);
+            ++(this->count);
+            return p;
+        }
+
+        auto push_back(const T &value) -> bool {
+            return this->emplace_back(value) != nullptr;
+        }
+
+        auto push_back(T &&value) -> bool {
+            return this->emplace_back(std::move(value)) != nullptr;
+        }
+
+        auto pop_back() -> void {
+            --(this->count);
+            this->end()->~T();
+        }
+
+        template<class... Args>
+        auto emplace(const_iterator pos, Args&&... args) -> iterator {
+            size_t index = pos - this->begin();
+            if(this->count == this->limit) {
+                T value(std::forward<Args>(args)...);
+                if(!this->reserve(this->limit * 2)) {
+                    return nullptr;
+                }
+                return this->emplace(this->begin() + index, std::move(value));
+            }
+            T *at = this->begin() + index;
+            KCORE_INNER_NAMESPACE::insert_at(at, this->end(), std::forward<Args>(args)...);
+            ++(this->count);
+            return at;
+        }
+
+        auto insert(const_iterator pos, const T &value) -> iterator {
+            return this->emplace(pos, value);
+        }
+
+        auto insert(const_iterator pos, T &&value) -> iterator {
+            return this->emplace(pos, std::move(value));
+        }
+
+        auto erase(const_iterator first, const_iterator last) -> iterator {
+            T *from = this->begin() + (first - this->begin());
+            T *to = this->begin() + (last - this->begin());
+            KCORE_INNER_NAMESPACE::erase_range(from, to, this->end());
+            this->count -= to - from;
+            return from;
+        }
+
+        auto erase(const_iterator pos) -> iterator {
+            return this->erase(pos, pos + 1);
+        }
+
+        auto reserve(size_t n) -> bool {
+            if(n <= this->limit) {
+                return true;
+            }
+            size_t units = (n * sizeof(T) + sizeof(unit) - 1) / sizeof(unit);
+            unit *raw = this->alloc->allocate(units);
+            if(raw == nullptr) {
+                return false;
+            }
+            if(reinterpret_cast<uintptr_t>(raw) % alignof(T) != 0) {
+                this->alloc->deallocate(raw, units);
+                return false;
+            }
+            T *grown = reinterpret_cast<T *>(raw);
+            KCORE_INNER_NAMESPACE::relocate(grown, this->elems, this->count);
+            this->release();
+            this->elems = grown;
+            this->limit = n;
+            return true;
+        }
+
+        auto resize(size_t n) -> bool {
+            if(!this->reserve(n)) {
+                return false;
+            }
+            while(this->count > n) {
+                this->pop_back();
+            }
+            while(this->count < n) {
+                this->emplace_back();
+            }
+            return true;
+        }
+
+        auto clear() -> void {
+            KCORE_INNER_NAMESPACE::destroy(this->begin(), this->end());
+            this->count = 0;
+        }
+
+    private:
+        auto inline_data() const -> T * {
+            return const_cast<T *>(reinterpret_cast<const T *>(this->storage));
+        }
+
+        // Gives a spilled buffer back, leaving the (empty) vector inline.
+        auto release() -> void {
+            if(!this->is_inline()) {
+                this->alloc->deallocate(reinterpret_cast<unit *>(this->elems),
+                    (this->limit * sizeof(T) + sizeof(unit) - 1) / sizeof(unit));
+                this->elems = this->inline_data();
+                this->limit = N;
+            }
+        }
+
+        // Takes other's elements without allocating; this is empty, inline
+        // and uses other's allocator.
+        auto take(small_vector &other) -> void {
+            if(other.is_inline()) {
+                KCORE_INNER_NAMESPACE::relocate(this->elems, other.elems, other.count);
+            } else {
+                this->elems = other.elems;
+                this->limit = other.limit;
+                other.elems = other.inline_data();
+                other.limit = N;
+            }
+            this->count = other.count;
+            other.count = 0;
+        }
+
+    private:
+        T *elems;
+        size_t count;
+        size_t limit;
+        Alloc *alloc;
+        alignas(T) unsigned char storage[sizeof(T) * N];
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* SMALL_VECTOR_H_ */
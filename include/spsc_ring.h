@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Single-producer single-consumer ring buffer.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef SPSC_RING_H_
+#define SPSC_RING_H_
+
+#include "constants.h"
+#include "allocator.h"
+#include "stl/stddef.h"
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+// Slot storage of an spsc_ring: N slots from Alloc, an array_allocator.
+// slots() is null when Alloc could not provide them.
+template<class T, size_t N, class Alloc>
+class ring_storage {
+    private:
+        using unit = typename Alloc::value_type;
+        static constexpr size_t units = (N * sizeof(T) + sizeof(unit) - 1) / sizeof(unit);
+    public:
+        explicit ring_storage(Alloc &alloc) : alloc(&alloc), mem(nullptr) {
+            unit *raw = alloc.allocate(units);
+            if(raw == nullptr) {
+                return;
+            }
+            if(reinterpret_cast<uintptr_t>(raw) % alignof(T) != 0) {
+                alloc.deallocate(raw, units);
+                return;
+            }
+            this->mem = reinterpret_cast<T *>(raw);
+        }
+        ring_storage(const ring_storage &) = delete;
+        ~ring_storage() {
+            if(this->mem != nullptr) {
+                this->alloc->deallocate(reinterpret_cast<unit *>(this->mem), units);
+            }
+        }
+
+        auto slots() const -> T * { return this->mem; }
+
+    private:
+        Alloc *alloc;
+        T *mem;
+};
+
+// N slots inline.
+template<class T, size_t N>
+class ring_storage<T, N, void> {
+    public:
+        auto slots() const -> T * {
+            return const_cast<T *>(reinterpret_cast<const T *>(this->bytes));
+        }
+
+    private:
+        alignas(KCORE_CACHE_LINE) alignas(T) unsigned char bytes[sizeof(T) * N];
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * Wait-free ring buffer handing elements from exactly one producer thread
+ * to exactly one consumer thread. N is a power of two; all N slots are
+ * usable. Slots live inline when Alloc is void, otherwise they come from
+ * Alloc, an array_allocator passed to the constructor; valid() tells
+ * whether it could provide them. A ring without slots is always full and
+ * always empty, so its calls fail as they would on a full or empty ring.
+ *
+ * The producer calls push(), emplace(), push_n(), reserve() and commit();
+ * the consumer calls pop(), pop_n(), peek() and consume(). Each side
+ * keeps a private copy of the other side's index and only re-reads the
+ * shared one when that copy says the ring is full (or empty), so in the
+ * steady state neither side touches the other's cache line.
+ *
+ * Nothing blocks or throws: a full ring makes push() return false and
+ * push_n() return how many elements fit, an empty one does the same for
+ * pop() and pop_n(). reserve() and peek() hand out slots in place:
+ *
+ *     size_t n = 32;
+ *     if(frame *f = ring.reserve(n)) {          // n: contiguous free slots
+ *         for(size_t i = 0; i < n; ++i) {
+ *             new (f + i) frame(...);
+ *         }
+ *         ring.commit(n);
+ *     }
+ */
+template<class T, size_t N, class Alloc = void>
+    requires std::is_void<Alloc>::value || array_allocator<Alloc>
+class spsc_ring : private KCORE_INNER_NAMESPACE::ring_storage<T, N, Alloc> {
+    static_assert(N > 0 && (N & (N - 1)) == 0, "spsc_ring capacity must be a power of two");
+    private:
+        using storage = KCORE_INNER_NAMESPACE::ring_storage<T, N, Alloc>;
+        static constexpr size_t mask = N - 1;
+    public:
+        using value_type = T;
+    public:
+        spsc_ring() = default;
+        using storage::storage;
+        spsc_ring(const spsc_ring &) = delete;
+        spsc_ring(const spsc_ring &&) = delete;
+        ~spsc_ring() {
+            size_t h = this->head.load(std::memory_order_relaxed);
+            size_t t = this->tail.load(std::memory_order_relaxed);
+            for(; h != t; ++h) {
+                this->slot(h)->~T();
+            }
+        }
+    public:
+        static constexpr auto capacity() -> size_t { return N; }
+
+        auto valid() const -> bool { return this->slots() != nullptr; }
+
+        // Elements in the ring at some point during the call.
+        auto size() const -> size_t {
+            size_t h = this->head.load(std::memory_order_acquire);
+            return this->tail.load(std::memory_order_acquire) - h;
+        }
+
+        auto empty() const -> bool { return this->size() == 0; }
+
+        // Producer side.
+
+        template<class... Args>
+        auto emplace(Args&&... args) -> bool {
+            size_t t = this->tail.load(std::memory_order_relaxed);
+            if(this->writable(t, 1) == 0) {
+                return false;
+            }
+            ::new (this->slot(t)) T(std::forward<Args>(args)...);
+            this->tail.store(t + 1, std::memory_order_release);
+            return true;
+        }
+
+        auto push(const T &value) -> bool { return this->emplace(value); }
+        auto push(T &&value) -> bool { return this->emplace(std::move(value)); }
+
+        // Copies up to n elements from in and publishes them together;
+        // returns how many fitted.
+        auto push_n(const T *in, size_t n) -> size_t {
+            size_t t = this->tail.load(std::memory_order_relaxed);
+            size_t free = this->writable(t, n);
+            if(n > free) {
+                n = free;
+            }
+            for(size_t i = 0; i < n; ++i) {
+                ::new (this->slot(t + i)) T(in[i]);
+            }
+            this->tail.store(t + n, std::memory_order_release);
+            return n;
+        }
+
+        // Up to n contiguous unconstructed slots for in-place writes, n
+        // set to how many; null if the ring is full. Construct the
+        // elements, then commit() them.
+        auto reserve(size_t &n) -> T * {
+            size_t t = this->tail.load(std::memory_order_relaxed);
+            size_t free = this->writable(t, n);
+            size_t run = N - (t & mask);
+            if(free > run) {
+                free = run;
+            }
+            if(n > free) {
+                n = free;
+            }
+            return n == 0 ? nullptr : this->slot(t);
+        }
+
+        // Publishes the first n slots handed out by reserve().
+        auto commit(size_t n) -> void {
+            size_t t = this->tail.load(std::memory_order_relaxed);
+            this->tail.store(t + n, std::memory_order_release);
+        }
+
+        // Consumer side.
+
+        auto pop(T &out) -> bool {
+            return this->pop_n(&out, 1) == 1;
+        }
+
+        // Moves up to n elements into out; returns how many there were.
+        auto pop_n(T *out, size_t n) -> size_t {
+            size_t h = this->head.load(std::memory_order_relaxed);
+            size_t ready = this->readable(h, n);
+            if(n > ready) {
+                n = ready;
+            }
+            for(size_t i = 0; i < n; ++i) {
+                T *p = this->slot(h + i);
+                out[i] = std::move(*p);
+                p->~T();
+            }
+            this->head.store(h + n, std::memory_order_release);
+            return n;
+        }
+
+        // Up to n contiguous elements to read in place, n set to how
+        // many; null if the ring is empty. consume() them when done.
+        auto peek(size_t &n) -> T * {
+            size_t h = this->head.load(std::memory_order_relaxed);
+            size_t ready = this->readable(h, n);
+            size_t run = N - (h & mask);
+            if(ready > run) {
+                ready = run;
+            }
+            if(n > ready) {
+                n = ready;
+            }
+            return n == 0 ? nullptr : this->slot(h);
+        }
+
+        // Destroys the first n elements handed out by peek() and gives
+        // their slots back to the producer.
+        auto consume(size_t n) -> void {
+            size_t h = this->head.load(std::memory_order_relaxed);
+            for(size_t i = 0; i < n; ++i) {
+                this->slot(h + i)->~T();
+            }
+            this->head.store(h + n, std::memory_order_release);
+        }
+
+    private:
+        auto slot(size_t index) const -> T * {
+            return this->slots() + (index & mask);
+        }
+
+        // Free slots as the producer sees them, reloading head only when
+        // the cached copy leaves fewer than want.
+        auto writable(size_t t, size_t want) -> size_t {
+            if(!this->valid()) {
+                return 0;
+            }
+            size_t free = N - (t - this->head_cache);
+            if(free < want) {
+                this->head_cache = this->head.load(std::memory_order_acquire);
+                free = N - (t - this->head_cache);
+            }
+            return free;
+        }
+
+        auto readable(size_t h, size_t want) -> size_t {
+            if(!this->valid()) {
+                return 0;
+            }
+            size_t ready = this->tail_cache - h;
+            if(ready < want) {
+                this->tail_cache = this->tail.load(std::memory_order_acquire);
+                ready = this->tail_cache - h;
+            }
+            return ready;
+        }
+
+    private:
+        // Indices count up forever and are masked on use. Each line is
+        // written by one side only: tail and head_cache by the producer,
+        // head and tail_cache by the consumer.
+        alignas(KCORE_CACHE_LINE) std::atomic<size_t> tail{0};
+        size_t head_cache = 0;
+        alignas(KCORE_CACHE_LINE) std::atomic<size_t> head{0};
+        size_t tail_cache = 0;
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* SPSC_RING_H_ */
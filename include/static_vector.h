@@ -0,0 +1,285 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Fixed-capacity vector with inline storage.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef STATIC_VECTOR_H_
+#define STATIC_VECTOR_H_
+
+#include "constants.h"
+#include "stl/string.h"
+#include "stl/stddef.h"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+// Element moves shared by static_vector and small_vector. Trivially
+// copyable elements go through memcpy/memmove.
+
+// Copy-constructs n elements into uninitialized dst.
+template<class T>
+auto copy_into(T *dst, const T *src, size_t n) -> void {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if(n != 0) {
+            memcpy(dst, src, n * sizeof(T));
+        }
+    } else {
+        for(size_t i = 0; i < n; ++i) {
+            ::new (dst + i) T(src[i]);
+        }
+    }
+}
+
+// Moves n elements into uninitialized dst and destroys the sources.
+template<class T>
+auto relocate(T *dst, T *src, size_t n) -> void {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        if(n != 0) {
+            memcpy(dst, src, n * sizeof(T));
+        }
+    } else {
+        for(size_t i = 0; i < n; ++i) {
+            ::new (dst + i) T(std::move(src[i]));
+            src[i].~T();
+        }
+    }
+}
+
+template<class T>
+auto destroy(T *first, T *last) -> void {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+        for(; first != last; ++first) {
+            first->~T();
+        }
+    }
+}
+
+// Constructs T(args...) at pos within [begin, end), which has room for
+// one more element, shifting the tail up by one.
+template<class T, class... Args>
+auto insert_at(T *pos, T *end, Args&&... args) -> T * {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        T value(std::forward<Args>(args)...);
+        memmove(pos + 1, pos, (end - pos) * sizeof(T));
+        memcpy(pos, &value, sizeof(T));
+    } else {
+        ::new (end) T(std::forward<Args>(args)...);
+        std::rotate(pos, end, end + 1);
+    }
+    return pos;
+}
+
+// Removes [first, last) from [first, end), shifting the tail down.
+template<class T>
+auto erase_range(T *first, T *last, T *end) -> void {
+    if constexpr (std::is_trivially_copyable_v<T>) {
+        memmove(first, last, (end - last) * sizeof(T));
+    } else {
+        T *tail = std::move(last, end, first);
+        destroy(tail, end);
+    }
+}
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * Vector of at most N elements stored inline; it never touches the heap.
+ * Growing past N does not throw: push_back() returns false, emplace_back()
+ * and insert() return nullptr, resize() returns false, and the vector is
+ * left unchanged.
+ */
+template<class T, size_t N>
+class static_vector {
+    static_assert(N > 0, "static_vector needs room for one element");
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using iterator = T *;
+        using const_iterator = const T *;
+    public:
+        static_vector() : count(0) {}
+        static_vector(const static_vector &other) : count(other.count) {
+            KCORE_INNER_NAMESPACE::copy_into(this->data(), other.data(), other.count);
+        }
+        static_vector(static_vector &&other) : count(other.count) {
+            KCORE_INNER_NAMESPACE::relocate(this->data(), other.data(), other.count);
+            other.count = 0;
+        }
+        ~static_vector() {
+            this->clear();
+        }
+
+        auto operator=(const static_vector &other) -> static_vector & {
+            if(this != &other) {
+                this->clear();
+                KCORE_INNER_NAMESPACE::copy_into(this->data(), other.data(), other.count);
+                this->count = other.count;
+            }
+            return *this;
+        }
+        auto operator=(static_vector &&other) -> static_vector & {
+            if(this != &other) {
+                this->clear();
+                KCORE_INNER_NAMESPACE::relocate(this->data(), other.data(), other.count);
+                this->count = other.count;
+                other.count = 0;
+            }
+            return *this;
+        }
+    public:
+        auto data() -> T * {
+            return reinterpret_cast<T *>(this->storage);
+        }
+
+        auto data() const -> const T * {
+            return reinterpret_cast<const T *>(this->storage);
+        }
+
+        auto size() const -> size_t {
+            return this->count;
+        }
+
+        static constexpr auto capacity() -> size_t {
+            return N;
+        }
+
+        auto empty() const -> bool {
+            return this->count == 0;
+        }
+
+        auto full() const -> bool {
+            return this->count == N;
+        }
+
+        auto begin() -> iterator { return this->data(); }
+        auto end() -> iterator { return this->data() + this->count; }
+        auto begin() const -> const_iterator { return this->data(); }
+        auto end() const -> const_iterator { return this->data() + this->count; }
+
+        auto operator[](size_t i) -> T & { return this->data()[i]; }
+        auto operator[](size_t i) const -> const T & { return this->data()[i]; }
+        auto front() -> T & { return this->data()[0]; }
+        auto back() -> T & { return this->data()[this->count - 1]; }
+
+    public:
+        template<class... Args>
+        auto emplace_back(Args&&... args) -> T * {
+            if(this->full()) {
+                return nullptr;
+            }
+            T *p = ::new (this->end()) T(std::forward<Args>(args)...);
+            ++(this->count);
+            return p;
+        }
+
+        auto push_back(const T &value) -> bool {
+            return this->emplace_back(value) != nullptr;
+        }
+
+        auto push_back(T &&value) -> bool {
+            return this->emplace_back(std::move(value)) != nullptr;
+        }
+
+        auto pop_back() -> void {
+            --(this->count);
+            this->end()->~T();
+        }
+
+        template<class... Args>
+        auto emplace(const_iterator pos, Args&&... args) -> iterator {
+            if(this->full()) {
+                return nullptr;
+            }
+            T *at = this->begin() + (pos - this->begin());
+            KCORE_INNER_NAMESPACE::insert_at(at, this->end(), std::forward<Args>(args)...);
+            ++(this->count);
+            return at;
+        }
+
+        auto insert(const_iterator pos, const T &value) -> iterator {
+            return this->emplace(pos, value);
+        }
+
+        auto insert(const_iterator pos, T &&value) -> iterator {
+            return this->emplace(pos, std::move(value));
+        }
+
+        auto erase(const_iterator first, const_iterator last) -> iterator {
+            T *from = this->begin() + (first - this->begin());
+            T *to = this->begin() + (last - this->begin());
+            KCORE_INNER_NAMESPACE::erase_range(from, to, this->end());
+            this->count -= to - from;
+            return from;
+        }
+
+        auto erase(const_iterator pos) -> iterator {
+            return this->erase(pos, pos + 1);
+        }
+
+        auto resize(size_t n) -> bool {
+            if(n > N) {
+                return false;
+            }
+            while(this->count > n) {
+                this->pop_back();
+            }
+            while(this->count < n) {
+                this->emplace_back();
+            }
+            return true;
+        }
+
+        auto clear() -> void {
+            KCORE_INNER_NAMESPACE::destroy(this->begin(), this->end());
+            this->count = 0;
+        }
+
+    private:
+        size_t count;
+        alignas(T) unsigned char storage[sizeof(T) * N];
+};
+
+} /* KCORE_NAMESPACE */
+
+#endif /* STATIC_VECTOR_H_ */
@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2004, Swedish Institute of Computer Science.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the Institute nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE INSTITUTE AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE INSTITUTE OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ *
+ * Author: tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+/**
+ * \file
+ *         Two-Level Segregated Fit allocator.
+ * \author
+ *         tiannian <dtiannian@aliyun.com>
+ *
+ */
+
+#ifndef TLSF_ALLOCATOR_H_
+#define TLSF_ALLOCATOR_H_
+
+#include "constants.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+
+namespace KCORE_NAMESPACE {
+
+namespace KCORE_INNER_NAMESPACE {
+
+struct tlsf_block {
+    tlsf_block *prev_phys;  // physically preceding block, null for the first
+    size_t size;            // payload bytes | tlsf_free_bit
+    // Only meaningful while the block is free; overlaps the payload.
+    tlsf_block *next_free;
+    tlsf_block *prev_free;
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+/*
+ * TLSF (Masmano et al.) over a caller-provided memory region. Free blocks
+ * are kept in segregated lists indexed by a first level (power of two)
+ * and a second level (linear subdivision of that power of two); two
+ * levels of bitmaps find a non-empty list that is guaranteed to fit, so
+ * allocate() and deallocate() run in constant time. Freed blocks are
+ * merged with free physical neighbours immediately.
+ *
+ * Every block carries a 16 byte header and payloads are 16 byte aligned.
+ */
+template<class Tp>
+class tlsf_allocator {
+    private:
+        using block = KCORE_INNER_NAMESPACE::tlsf_block;
+
+        static constexpr int align_log2 = 4;
+        static constexpr size_t align_size = size_t(1) << align_log2;
+        static constexpr int sl_log2 = 5;
+        static constexpr int sl_count = 1 << sl_log2;
+        static constexpr int fl_shift = sl_log2 + align_log2;
+        static constexpr int fl_max = 32;
+        static constexpr int fl_count = fl_max - fl_shift + 1;
+        static constexpr size_t small_size = size_t(1) << fl_shift;
+
+        static constexpr size_t header_size = 2 * sizeof(void *);
+        static constexpr size_t min_block = 2 * sizeof(void *);
+        static constexpr size_t max_block = (size_t(1) << fl_max) - 1;
+        static constexpr size_t free_bit = 1;
+
+        static_assert(header_size == align_size, "tlsf_allocator assumes 16 byte headers");
+        static_assert(alignof(Tp) <= align_size, "tlsf_allocator payloads are 16 byte aligned");
+    public:
+        using value_type = Tp;
+    public:
+        tlsf_allocator(void *region, size_t bytes) : fl_bitmap(0), sl_bitmap{}, lists{}, free_total(0) {
+            auto begin = reinterpret_cast<uintptr_t>(region);
+            auto end = begin + bytes;
+            begin = (begin + align_size - 1) & ~(uintptr_t)(align_size - 1);
+            end &= ~(uintptr_t)(align_size - 1);
+            this->region_begin = reinterpret_cast<unsigned char *>(begin);
+            this->region_end = reinterpret_cast<unsigned char *>(end);
+            if(end < begin + 2 * header_size + min_block) {
+                return;
+            }
+
+            size_t payload = end - begin - 2 * header_size;
+            if(payload > max_block) {
+                payload = max_block & ~(align_size - 1);
+            }
+            block *first = reinterpret_cast<block *>(begin);
+            first->prev_phys = nullptr;
+            first->size = payload;
+
+            // Zero-sized used block that stops merging past the end.
+            block *sentinel = next_phys(first);
+            sentinel->prev_phys = first;
+            sentinel->size = 0;
+
+            this->insert(first);
+        }
+        tlsf_allocator(const tlsf_allocator &) = delete;
+        tlsf_allocator(const tlsf_allocator &&) = delete;
+        ~tlsf_allocator() = default;
+    public:
+        // impl array_allocator
+        auto allocate(size_t n) -> Tp* {
+            if(n > SIZE_MAX / sizeof(Tp)) {
+                return nullptr;
+            }
+            size_t size = adjust(n * sizeof(Tp));
+            if(size == 0) {
+                return nullptr;
+            }
+            int fl, sl;
+            mapping_search(size, fl, sl);
+            block *b = this->search(fl, sl);
+            if(b == nullptr) {
+                return nullptr;
+            }
+            this->remove(b, fl, sl);
+
+            if(size_of(b) >= size + header_size + min_block) {
+                block *rest = reinterpret_cast<block *>(payload_of(b) + size);
+                rest->prev_phys = b;
+                rest->size = size_of(b) - size - header_size;
+                next_phys(rest)->prev_phys = rest;
+                b->size = size;
+                this->insert(rest);
+            }
+            b->size &= ~free_bit;
+            return reinterpret_cast<Tp *>(payload_of(b));
+        }
+
+        auto deallocate(Tp *p, size_t) -> void {
+            if(p == nullptr) {
+                return;
+            }
+            block *b = reinterpret_cast<block *>(
+                reinterpret_cast<unsigned char *>(p) - header_size);
+            if(is_free(b)) {
+                return;
+            }
+
+            block *prev = b->prev_phys;
+            if(prev != nullptr && is_free(prev)) {
+                this->remove(prev);
+                prev->size = size_of(prev) + header_size + size_of(b);
+                b = prev;
+            }
+            block *next = next_phys(b);
+            if(is_free(next)) {
+                this->remove(next);
+                b->size = size_of(b) + header_size + size_of(next);
+            }
+            next_phys(b)->prev_phys = b;
+            this->insert(b);
+        }
+
+    public:
+        auto has(Tp *ptr) const -> bool {
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            return addr >= this->region_begin && addr < this->region_end;
+        }
+
+        // Total payload bytes on the free lists.
+        auto free_bytes() const -> size_t {
+            return this->free_total;
+        }
+
+        // Payload bytes of the largest free block. Walks one free list, so
+        // it is meant for monitoring rather than the allocation path.
+        auto largest_free_block() const -> size_t {
+            if(this->fl_bitmap == 0) {
+                return 0;
+            }
+            int fl = fls(this->fl_bitmap);
+            int sl = fls(this->sl_bitmap[fl]);
+            size_t largest = 0;
+            for(block *b = this->lists[fl][sl]; b != nullptr; b = b->next_free) {
+                if(size_of(b) > largest) {
+                    largest = size_of(b);
+                }
+            }
+            return largest;
+        }
+
+        // 1 - largest free block / free bytes: 0 when all free memory is
+        // one block, approaching 1 as it splinters.
+        auto fragmentation() const -> double {
+            if(this->free_total == 0) {
+                return 0.0;
+            }
+            return 1.0 - double(this->largest_free_block()) / double(this->free_total);
+        }
+
+    private:
+        static auto fls(uint64_t x) -> int {
+            return 63 - __builtin_clzll(x);
+        }
+
+        static auto ffs(uint64_t x) -> int {
+            return __builtin_ctzll(x);
+        }
+
+        static auto size_of(const block *b) -> size_t {
+            return b->size & ~free_bit;
+        }
+
+        static auto is_free(const block *b) -> bool {
+            return (b->size & free_bit) != 0;
+        }
+
+        static auto payload_of(block *b) -> unsigned char * {
+            return reinterpret_cast<unsigned char *>(b) + header_size;
+        }
+
+        static auto next_phys(block *b) -> block * {
+            return reinterpret_cast<block *>(payload_of(b) + size_of(b));
+        }
+
+        // Request size rounded to the block granularity, or 0 if too large.
+        static auto adjust(size_t bytes) -> size_t {
+            if(bytes > max_block - align_size) {
+                return 0;
+            }
+            size_t size = (bytes + align_size - 1) & ~(align_size - 1);
+            return size < min_block ? min_block : size;
+        }
+
+        static auto mapping_insert(size_t size, int &fl, int &sl) -> void {
+            if(size < small_size) {
+                fl = 0;
+                sl = static_cast<int>(size / (small_size / sl_count));
+            } else {
+                int f = fls(size);
+                sl = static_cast<int>(size >> (f - sl_log2)) ^ sl_count;
+                fl = f - (fl_shift - 1);
+            }
+        }
+
+        // Like mapping_insert, but rounds up to the next list so any block
+        // found there is large enough.
+        static auto mapping_search(size_t size, int &fl, int &sl) -> void {
+            if(size >= small_size) {
+                size += (size_t(1) << (fls(size) - sl_log2)) - 1;
+            }
+            mapping_insert(size, fl, sl);
+        }
+
+        auto search(int &fl, int &sl) -> block * {
+            if(fl >= fl_count) {
+                return nullptr;
+            }
+            uint64_t sl_map = this->sl_bitmap[fl] & (~uint64_t(0) << sl);
+            if(sl_map == 0) {
+                uint64_t fl_map = this->fl_bitmap & (~uint64_t(0) << (fl + 1));
+                if(fl_map == 0) {
+                    return nullptr;
+                }
+                fl = ffs(fl_map);
+                sl_map = this->sl_bitmap[fl];
+            }
+            sl = ffs(sl_map);
+            return this->lists[fl][sl];
+        }
+
+        auto insert(block *b) -> void {
+            int fl, sl;
+            mapping_insert(size_of(b), fl, sl);
+            block *head = this->lists[fl][sl];
+            b->size |= free_bit;
+            b->next_free = head;
+            b->prev_free = nullptr;
+            if(head != nullptr) {
+                head->prev_free = b;
+            }
+            this->lists[fl][sl] = b;
+            this->fl_bitmap |= uint64_t(1) << fl;
+            this->sl_bitmap[fl] |= uint64_t(1) << sl;
+            this->free_total += size_of(b);
+        }
+
+        auto remove(block *b) -> void {
+            int fl, sl;
+            mapping_insert(size_of(b), fl, sl);
+            this->remove(b, fl, sl);
+        }
+
+        auto remove(block *b, int fl, int sl) -> void {
+            if(b->prev_free != nullptr) {
+                b->prev_free->next_free = b->next_free;
+            } else {
+                this->lists[fl][sl] = b->next_free;
+                if(b->next_free == nullptr) {
+                    this->sl_bitmap[fl] &= ~(uint64_t(1) << sl);
+                    if(this->sl_bitmap[fl] == 0) {
+                        this->fl_bitmap &= ~(uint64_t(1) << fl);
+                    }
+                }
+            }
+            if(b->next_free != nullptr) {
+                b->next_free->prev_free = b->prev_free;
+            }
+            b->size &= ~free_bit;
+            this->free_total -= size_of(b);
+        }
+
+    private:
+        unsigned char *region_begin;
+        unsigned char *region_end;
+        uint64_t fl_bitmap;
+        uint64_t sl_bitmap[fl_count];
+        block *lists[fl_count][sl_count];
+        size_t free_total;
+};
+
+template<class T1, class T2>
+constexpr bool operator==( const tlsf_allocator<T1>& lhs, const tlsf_allocator<T2>& rhs ) {
+    return &lhs == &rhs;
+}
+
+template<class T1, class T2>
+constexpr bool operator!=( const tlsf_allocator<T1>& lhs, const tlsf_allocator<T2>& rhs ) {
+    return &lhs != &rhs;
+}
+
+}
+
+#endif /* TLSF_ALLOCATOR_H_ */
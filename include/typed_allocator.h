@@ -42,17 +42,163 @@
 #define TYPED_ALLOCATOR_H_
 
 #include "constants.h"
-#include "stl/kstring.h"
-#include "stl/kstddef.h"
+#include "stl/string.h"
+#include "stl/stddef.h"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace KCORE_NAMESPACE {
 
-template<class Tp, int N> 
-class typed_allocator {
+namespace KCORE_INNER_NAMESPACE {
+
+// Smallest unsigned integer able to hold every slot index plus an
+// end-of-list sentinel (the value N itself).
+template<long N>
+using slot_index_t = 
+    std::conditional_t<(N < 0xff), uint8_t,
+    std::conditional_t<(N < 0xffff), uint16_t,
+    std::conditional_t<(N < 0xffffffffL), uint32_t, uint64_t>>>;
+
+template<class A, class B>
+constexpr auto max_align() -> size_t {
+    return alignof(A) > alignof(B) ? alignof(A) : alignof(B);
+}
+
+struct cache_line {
+    alignas(KCORE_CACHE_LINE) unsigned char bytes[KCORE_CACHE_LINE];
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+// typed_allocator initialization policies.
+//
+// eager_init: the constructor zeroes the whole pool, so it can live
+// anywhere and slots are zero-filled on first use.
+//
+// lazy_init: the constructor is trivial and does nothing. The pool must
+// start out zeroed, i.e. have static storage duration (it then sits in
+// .bss and needs no startup code) or be value-initialized. Pages of the
+// pool are only touched as slots are handed out for the first time.
+struct eager_init {};
+struct lazy_init {};
+
+// typed_allocator slot layout policies.
+//
+// packed_layout: slots sit back to back and a free slot holds the free
+// list link itself. Smallest, but neighbouring slots share cache lines.
+//
+// padded_layout: every slot starts on its own cache line, so objects
+// handed to different threads never share one.
+//
+// split_layout: slots stay packed, but free list links and counts live
+// in their own array on separate cache lines, so the allocator never
+// touches payload lines and payload writes never touch its metadata.
+struct packed_layout {};
+struct padded_layout {};
+struct split_layout {};
+
+namespace KCORE_INNER_NAMESPACE {
+
+// State of a typed_allocator under each layout. In all of them all-zero
+// is the empty pool: links and free_head hold slot index + 1 with 0
+// ending the list, and slots at or past the watermark have never been
+// handed out, so neither they nor their count[] entries are touched
+// until then.
+template<class Tp, long N, class Layout, class Count>
+struct slot_storage;
+
+template<class Tp, long N, class Count>
+struct slot_storage<Tp, N, packed_layout, Count> {
+    using index_type = slot_index_t<N>;
+
+    union slot {
+        index_type next;
+        alignas(Tp) unsigned char data[sizeof(Tp)];
+    };
+    static_assert(alignof(slot) >= alignof(Tp) && sizeof(slot) % alignof(Tp) == 0,
+        "packed slots must keep Tp aligned");
+
+    auto link(size_t pos) -> index_type & {
+        return this->mem[pos].next;
+    }
+
+    slot mem[N];
+    Count count[N];
+    index_type free_head;
+    index_type watermark;
+    index_type used;
+};
+
+template<class Tp, long N, class Count>
+struct slot_storage<Tp, N, padded_layout, Count> {
+    using index_type = slot_index_t<N>;
+
+    union alignas(max_align<Tp, cache_line>()) slot {
+        index_type next;
+        alignas(Tp) unsigned char data[sizeof(Tp)];
+    };
+    static_assert(alignof(slot) >= alignof(Tp) && sizeof(slot) % alignof(Tp) == 0,
+        "padded slots must keep Tp aligned");
+    static_assert(sizeof(slot) % KCORE_CACHE_LINE == 0,
+        "padded slots must fill whole cache lines");
+
+    auto link(size_t pos) -> index_type & {
+        return this->mem[pos].next;
+    }
+
+    slot mem[N];
+    Count count[N];
+    index_type free_head;
+    index_type watermark;
+    index_type used;
+};
+
+template<class Tp, long N, class Count>
+struct slot_storage<Tp, N, split_layout, Count> {
+    using index_type = slot_index_t<N>;
+
+    struct slot {
+        alignas(Tp) unsigned char data[sizeof(Tp)];
+    };
+    static_assert(alignof(slot) >= alignof(Tp) && sizeof(slot) % alignof(Tp) == 0,
+        "split slots must keep Tp aligned");
+
+    auto link(size_t pos) -> index_type & {
+        return this->links[pos];
+    }
+
+    alignas(max_align<slot, cache_line>()) slot mem[N];
+    alignas(KCORE_CACHE_LINE) index_type links[N];
+    Count count[N];
+    index_type free_head;
+    index_type watermark;
+    index_type used;
+};
+
+} /* KCORE_INNER_NAMESPACE */
+
+// Count is the type of the per-slot reference count. The default char
+// keeps metadata at one byte per slot; pools shared through many
+// pool_shared_ptr copies can pick a wider unsigned type, e.g. uint16_t.
+
+template<class Tp, int N, class Init = eager_init, class Layout = packed_layout, class Count = char> 
+class typed_allocator : private KCORE_INNER_NAMESPACE::slot_storage<Tp, N, Layout, Count> {
+    static_assert(N > 0, "typed_allocator needs at least one slot");
+    static_assert(std::is_integral_v<Count>, "typed_allocator counts are integers");
+    private:
+        using storage = KCORE_INNER_NAMESPACE::slot_storage<Tp, N, Layout, Count>;
+        using index_type = typename storage::index_type;
+        using slot = typename storage::slot;
     public:
-        typed_allocator() {
-            memset(this->count, 0, N);
-            memset(this->mem, 0, sizeof(Tp) * N);
+        typed_allocator() requires std::is_same_v<Init, lazy_init> = default;
+        typed_allocator() requires std::is_same_v<Init, eager_init> {
+            memset(this->count, 0, sizeof(this->count));
+            memset(this->mem, 0, sizeof(this->mem));
+            this->free_head = 0;
+            this->watermark = 0;
+            this->used = 0;
         }
         typed_allocator(const typed_allocator &) = delete;
         typed_allocator(const typed_allocator &&) = delete;
@@ -62,57 +208,125 @@ class typed_allocator {
     public:
         // impl allocator
         auto allocate() -> Tp* {
-            for(int i = 0; i < N; ++i) {
-                if(this->count[i] == 0) {
-                    ++(this->count[i]);
-                    return &(this->mem[i]);
-                }
+            index_type pos;
+            if(this->free_head != 0) {
+                pos = this->free_head - 1;
+                this->free_head = this->link(pos);
+            } else if(this->watermark < N) {
+                pos = (this->watermark)++;
+            } else {
+                return nullptr;
             }
-            return nullptr;
+            ++(this->used);
+            ++(this->count[pos]);
+            return reinterpret_cast<Tp *>(this->mem[pos].data);
         }
 
         auto deallocate(Tp *p) -> int {
+            return this->release(p, [](Tp *) {});
+        }
+
+    public:
+        // impl shared_allocator
+        // count[] is the slot's reference count; it saturates at the largest
+        // Count.
+        auto retain(Tp *p) -> int {
+            if(!this->has(p)) {
+                return -1;
+            }
+            auto pos = this->index_of(p);
+            if(this->count[pos] == 0 || this->count[pos] == std::numeric_limits<Count>::max()) {
+                return -1;
+            }
+            return ++(this->count[pos]);
+        }
+
+        // Drops one reference. The last one calls dispose(p) while the slot
+        // still holds the object, then links the slot into the free list.
+        // -1 for a foreign pointer or a slot that is already free.
+        template<class Dispose>
+        auto release(Tp *p, Dispose &&dispose) -> int {
             if(this->has(p)){
-                auto pos = (p - this->mem) / sizeof(Tp);
-                if (this->count[pos] > 0) {
-                    -- (this -> count[pos]);
+                auto pos = this->index_of(p);
+                if (this->count[pos] == 0) {
+                    return -1;
+                }
+                -- (this -> count[pos]);
+                if (this->count[pos] == 0) {
+                    dispose(p);
+                    this->link(pos) = this->free_head;
+                    this->free_head = static_cast<index_type>(pos + 1);
+                    --(this->used);
                 }
                 return this->count[pos];
             } 
             return -1;
         }
-;
+
     public:
-        // impl extend_allocator
-        auto available_count() -> size_t const {
-            int num_free = 0;
+        // impl batch_allocator
+        auto allocate_n(Tp **out, size_t n) -> size_t {
+            size_t got = 0;
+            index_type head = this->free_head;
+            while(got < n && head != 0) {
+                ++(this->count[head - 1]);
+                out[got++] = reinterpret_cast<Tp *>(this->mem[head - 1].data);
+                head = this->link(head - 1);
+            }
+            this->free_head = head;
+            while(got < n && this->watermark < N) {
+                ++(this->count[this->watermark]);
+                out[got++] = reinterpret_cast<Tp *>(this->mem[(this->watermark)++].data);
+            }
+            this->used += static_cast<index_type>(got);
+            return got;
+        }
 
-            for(int i = 0; i < N; ++i) {
-                if(this->count[i] == 0) {
-                    ++num_free;
+        auto deallocate_n(Tp **in, size_t n) -> size_t {
+            size_t freed = 0;
+            index_type head = this->free_head;
+            for(size_t i = 0; i < n; ++i) {
+                if(!this->has(in[i])) {
+                    continue;
+                }
+                auto pos = this->index_of(in[i]);
+                if(this->count[pos] > 0 && --(this->count[pos]) == 0) {
+                    this->link(pos) = head;
+                    head = static_cast<index_type>(pos + 1);
+                    ++freed;
                 }
             }
-            
-            return num_free;
+            this->free_head = head;
+            this->used -= static_cast<index_type>(freed);
+            return freed;
+        }
+
+    public:
+        // impl extend_allocator
+        auto available_count() -> size_t const {
+            return N - this->used;
         }
 
         auto has(Tp *ptr) -> bool const {
-            return ptr >= this->mem &&
-                ptr < this->mem + N + 1;
+            auto addr = reinterpret_cast<const unsigned char *>(ptr);
+            auto base = reinterpret_cast<const unsigned char *>(this->mem);
+            return addr >= base && addr < base + sizeof(slot) * N;
         }
-        
+
     private:
-        Tp mem[N];
-        char count[N];
+        auto index_of(Tp *ptr) const -> size_t {
+            return (reinterpret_cast<const unsigned char *>(ptr) -
+                reinterpret_cast<const unsigned char *>(this->mem)) / sizeof(slot);
+        }
 };
 
-template< class T1, int N1, class T2, int N2>
-constexpr bool operator==( const typed_allocator<T1, N1>& lhs, const typed_allocator<T2, N2>& rhs ) {
+template< class T1, int N1, class I1, class L1, class C1, class T2, int N2, class I2, class L2, class C2>
+constexpr bool operator==( const typed_allocator<T1, N1, I1, L1, C1>& lhs, const typed_allocator<T2, N2, I2, L2, C2>& rhs ) {
     return &lhs == &rhs;
 }
 
-template< class T1, int N1, class T2, int N2>
-constexpr bool operator!=( const typed_allocator<T1, N1>& lhs, const typed_allocator<T2, N2>& rhs ) {
+template< class T1, int N1, class I1, class L1, class C1, class T2, int N2, class I2, class L2, class C2>
+constexpr bool operator!=( const typed_allocator<T1, N1, I1, L1, C1>& lhs, const typed_allocator<T2, N2, I2, L2, C2>& rhs ) {
     return &lhs != &rhs;
 }
 
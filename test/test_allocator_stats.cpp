@@ -0,0 +1,101 @@
+#include "allocator.h"
+#include "allocator_stats.h"
+#include "pool_ptr.h"
+#include "tlsf_allocator.h"
+#include "typed_allocator.h"
+#include "cassert"
+#include "cstring"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires kcore::allocator<Alloc> && extend_allocator<Alloc>
+void test(Alloc &allocator) {
+    int *a = allocator.allocate();
+    assert( allocator.available_count() == 3 );
+    assert( allocator.has(a) == true );
+    assert( allocator.deallocate(a) == 0);
+}
+
+alignas(16) static unsigned char region[4096];
+
+int main() {
+    // disabled instrumentation is the bare pool
+    static_assert( sizeof(instrumented<typed_allocator<int,4>, no_stats>) ==
+        sizeof(typed_allocator<int,4>) );
+    instrumented<typed_allocator<int,4>, no_stats> plain("plain");
+    test(plain);
+
+    instrumented<typed_allocator<int,4>, pool_stats> pool("sensor");
+    test(pool);
+    int *all[5];
+    for(int i = 0; i < 5; ++i) {
+        all[i] = pool.allocate();
+    }
+    assert( all[4] == nullptr );
+    pool.deallocate(all[0]);
+    pool.deallocate(all[1]);
+    int outside;
+    pool.deallocate(&outside);
+
+    stats_snapshot s = pool.stats().snapshot();
+    assert( strcmp(s.name, "sensor") == 0 );
+    assert( s.allocations == 5 );
+    assert( s.failures == 1 );
+    assert( s.deallocations == 3 );
+    assert( s.current == 2 );
+    assert( s.peak == 4 );
+    uint64_t timed = 0;
+    for(int i = 0; i < stats_snapshot::buckets; ++i) {
+        timed += s.allocate_ns[i];
+    }
+    assert( timed == 6 );
+
+    // array pools and batch calls are counted too
+    {
+        instrumented<tlsf_allocator<char>, pool_stats> heap("heap", region, sizeof(region));
+        char *c = heap.allocate(100);
+        assert( heap.has(c) );
+        heap.deallocate(c, 100);
+        assert( heap.stats().snapshot().current == 0 );
+        assert( heap.stats().snapshot().peak == 1 );
+
+        int names = 0;
+        pool_stats::for_each([&](const stats_snapshot &snap) {
+            if(strcmp(snap.name, "heap") == 0 || strcmp(snap.name, "sensor") == 0) {
+                ++names;
+            }
+        });
+        assert( names == 2 );
+    }
+    int names = 0;
+    pool_stats::for_each([&](const stats_snapshot &) { ++names; });
+    assert( names == 1 );
+
+    instrumented<typed_allocator<int,4>, pool_stats> batch("batch");
+    int *got[4];
+    assert( batch.allocate_n(got, 6) == 4 );
+    assert( batch.deallocate_n(got, 4) == 4 );
+    s = batch.stats().snapshot();
+    assert( s.failures == 2 && s.peak == 4 && s.current == 0 );
+
+    // a double free is refused by the pool and not counted
+    assert( pool.deallocate(all[0]) == -1 );
+    s = pool.stats().snapshot();
+    assert( s.deallocations == 3 && s.current == 2 );
+
+    // shared handles end an allocation when the last one goes
+    {
+        instrumented<typed_allocator<int,4>, pool_stats> shared("shared");
+        {
+            auto first = make_shared_pooled<int>(shared, 7);
+            auto second = first;
+            first.reset();
+            assert( shared.stats().snapshot().current == 1 );
+        }
+        s = shared.stats().snapshot();
+        assert( s.allocations == 1 && s.deallocations == 1 && s.current == 0 );
+        assert( shared.available_count() == 4 );
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "allocator.h"
+#include "arena_allocator.h"
+#include "size_class_allocator.h"
+#include "tlsf_allocator.h"
+#include "cassert"
+#include "cstdint"
+#include "cstring"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires array_allocator<Alloc> && inner::array_allocate_with_hint<Alloc>
+void test(Alloc &allocator) {
+    int *a = allocator.allocate(4);
+    int *b = allocator.allocate(4, a);
+    assert( b == a + 4 );
+    allocator.deallocate(b, 4);
+    allocator.deallocate(a, 4);
+    assert( allocator.allocate(1) == a );
+    allocator.reset();
+}
+
+int main() {
+    arena_allocator<int, 256> arena;
+    test(arena);
+
+    int *a = arena.allocate(8);
+    auto outer = arena.checkpoint();
+    int *b = arena.allocate(8);
+    assert( b == a + 8 );
+    auto inner = arena.checkpoint();
+    arena.allocate(8);
+    arena.rewind(inner);
+    assert( arena.allocate(1) == b + 8 );
+    arena.rewind(outer);
+    assert( arena.allocate(1) == b );
+
+    // out of inline memory and no upstream to chain from
+    arena.reset();
+    assert( arena.allocate(64) != nullptr );
+    assert( arena.allocate(1) == nullptr );
+    arena.reset();
+    assert( arena.allocate(1) == a );
+
+    // byte counts that overflow are refused, not wrapped
+    assert( arena.allocate(SIZE_MAX / sizeof(int) + 1) == nullptr );
+    assert( arena.allocate(SIZE_MAX) == nullptr );
+    assert( arena.allocate(1) == a + 1 );
+
+    // a chained arena takes more blocks from the upstream and keeps them
+    // around after a reset
+    size_class_allocator<unsigned char, 1, 1, 1, 1, 1, 1, 2> upstream;
+    {
+        arena_allocator<long, 1024, decltype(upstream)> chained(upstream);
+        long *first = chained.allocate(100);
+        long *second = chained.allocate(100);
+        assert( first != nullptr && second != nullptr );
+        assert( upstream.stats(6).in_use == 1 );
+        chained.reset();
+        assert( chained.allocate(100) == first );
+        assert( chained.allocate(100) == second );
+        assert( chained.allocate(100) != nullptr );
+        assert( upstream.stats(6).in_use == 2 );
+        assert( chained.allocate(100) == nullptr );
+    }
+    assert( upstream.stats(6).in_use == 0 );
+
+    // a request larger than a chained block never reaches the upstream
+    {
+        arena_allocator<long, 1024, decltype(upstream)> chained(upstream);
+        assert( chained.allocate(200) == nullptr );
+        assert( upstream.stats(6).in_use == 0 );
+        assert( chained.allocate(SIZE_MAX / 4) == nullptr );
+        assert( upstream.stats(6).in_use == 0 );
+        long *a = chained.allocate(100);
+        assert( a != nullptr && upstream.stats(6).in_use == 0 );
+        assert( chained.allocate(100) != nullptr );
+        assert( upstream.stats(6).in_use == 1 );
+    }
+    assert( upstream.stats(6).in_use == 0 );
+
+    // Size need not be a multiple of the upstream unit: blocks round up
+    // and every byte handed out lies inside them
+    struct unit24 { char bytes[24]; };
+    alignas(16) static unsigned char region[1 << 14];
+    tlsf_allocator<unit24> heap(region, sizeof(region));
+    size_t heap_free = heap.free_bytes();
+    {
+        arena_allocator<char, 1000, decltype(heap)> odd(heap);
+        assert( odd.allocate(1000) != nullptr );
+        char *c = odd.allocate(1000 - sizeof(inner::arena_block));
+        assert( c != nullptr );
+        // a neighbour taken right after the block must survive a full write
+        unit24 *next = heap.allocate(2);
+        assert( next != nullptr );
+        memset(next, 0x11, 2 * sizeof(unit24));
+        memset(c, 0x5a, 1000 - sizeof(inner::arena_block));
+        for(size_t i = 0; i < 2 * sizeof(unit24); ++i) {
+            assert( reinterpret_cast<unsigned char *>(next)[i] == 0x11 );
+        }
+        heap.deallocate(next, 2);
+    }
+    assert( heap.free_bytes() == heap_free );
+    return 0;
+}
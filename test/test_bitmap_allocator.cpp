@@ -0,0 +1,69 @@
+#include "allocator.h"
+#include "bitmap_allocator.h"
+#include "cassert"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires allocator<Alloc> && extend_allocator<Alloc>
+void test(Alloc &allocator) {
+    int *a = allocator.allocate();
+    assert( allocator.available_count() == 69 );
+    assert( allocator.has(a) == true );
+    assert( allocator.deallocate(a) == 0);
+}
+
+int main() {
+    bitmap_allocator<int,70> allocator;
+    test(allocator);
+
+    // fill across the word boundary, padding bits are never handed out
+    int *all[70];
+    for(int i = 0; i < 70; ++i) {
+        all[i] = allocator.allocate();
+        assert( all[i] != nullptr );
+        assert( allocator.has(all[i]) == true );
+    }
+    assert( allocator.available_count() == 0 );
+    assert( allocator.allocate() == nullptr );
+
+    // lowest free slot is reused first
+    assert( allocator.deallocate(all[66]) == 0 );
+    assert( allocator.deallocate(all[2]) == 0 );
+    assert( allocator.available_count() == 2 );
+    assert( allocator.allocate() == all[2] );
+    assert( allocator.allocate() == all[66] );
+
+    int outside;
+    assert( allocator.deallocate(&outside) == -1 );
+
+    // freeing a slot twice is refused
+    assert( allocator.deallocate(all[5]) == 0 );
+    assert( allocator.deallocate(all[5]) == -1 );
+    assert( allocator.available_count() == 1 );
+    assert( allocator.allocate() == all[5] );
+
+    // batches take whole words at a time and may span several
+    bitmap_allocator<int,200> batch;
+    int *got[200];
+    assert( batch.allocate_n(got, 150) == 150 );
+    assert( batch.available_count() == 50 );
+    for(int i = 1; i < 150; ++i) {
+        assert( got[i] == got[i - 1] + 1 );
+    }
+    assert( batch.allocate_n(got + 150, 100) == 50 );
+    assert( batch.allocate() == nullptr );
+    assert( batch.deallocate_n(got, 200) == 200 );
+    assert( batch.available_count() == 200 );
+    assert( batch.deallocate_n(got, 2) == 0 );
+    assert( batch.allocate() == got[0] );
+
+    bitmap_allocator<char,1000> large;
+    for(int i = 0; i < 999; ++i) {
+        assert( large.allocate() != nullptr );
+    }
+    assert( large.available_count() == 1 );
+    assert( large.allocate() != nullptr );
+    assert( large.allocate() == nullptr );
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "allocator.h"
+#include "buddy_allocator.h"
+#include "cassert"
+#include "cstdint"
+#include "cstdlib"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires array_allocator<Alloc> && inner::array_allocate_with_hint<Alloc>
+void test(Alloc &allocator) {
+    char *a = allocator.allocate(300);
+    char *b = allocator.allocate(300, a);
+    assert( a != nullptr && b != nullptr );
+    allocator.deallocate(b, 300);
+    allocator.deallocate(a, 300);
+}
+
+using buddy = buddy_allocator<char, 8, 16, 4>;
+
+alignas(65536) static unsigned char region[4 * 65536];
+
+int main() {
+    buddy allocator(region, sizeof(region));
+    assert( allocator.free_bytes() == sizeof(region) );
+    test(allocator);
+    assert( allocator.free_bytes() == sizeof(region) );
+    assert( allocator.largest_free_block() == 65536 );
+    assert( allocator.fragmentation() == 0.0 );
+
+    // blocks are rounded up to a power of two and naturally aligned
+    char *a = allocator.allocate(1000);
+    assert( reinterpret_cast<uintptr_t>(a) % 1024 == 0 );
+    assert( allocator.free_bytes() == sizeof(region) - 1024 );
+    assert( allocator.allocate(65537) == nullptr );
+
+    // a hinted allocation lands next to the hint: the buddy of `a`
+    char *b = allocator.allocate(1000, a);
+    assert( b == a + 1024 );
+
+    // a hint in another top-level block splits that block instead
+    char *far = reinterpret_cast<char *>(region) + 3 * 65536 + 40000;
+    char *c = allocator.allocate(256, far);
+    assert( c >= reinterpret_cast<char *>(region) + 3 * 65536 );
+    assert( c <= far && far < c + 256 );
+
+    // freeing merges buddies all the way back up
+    allocator.deallocate(c, 256);
+    allocator.deallocate(a, 1000);
+    allocator.deallocate(a, 1000);
+    allocator.deallocate(b, 1000);
+    assert( allocator.free_bytes() == sizeof(region) );
+    assert( allocator.fragmentation() == 0.0 );
+
+    // fill with the smallest blocks, then free in random order
+    constexpr int count = sizeof(region) / 256;
+    static char *all[count];
+    for(int i = 0; i < count; ++i) {
+        all[i] = allocator.allocate(256);
+        assert( all[i] != nullptr );
+    }
+    assert( allocator.allocate(1) == nullptr );
+
+    // every other small block free: plenty of memory, nothing contiguous
+    for(int i = 0; i < count; i += 2) {
+        allocator.deallocate(all[i], 256);
+    }
+    assert( allocator.largest_free_block() == 256 );
+    assert( allocator.fragmentation() > 0.99 );
+    for(int i = 0; i < count; i += 2) {
+        all[i] = allocator.allocate(256);
+    }
+
+    srand(7);
+    for(int i = count - 1; i > 0; --i) {
+        int j = rand() % (i + 1);
+        char *t = all[i];
+        all[i] = all[j];
+        all[j] = t;
+    }
+    for(int i = 0; i < count; ++i) {
+        allocator.deallocate(all[i], 256);
+    }
+    assert( allocator.free_bytes() == sizeof(region) );
+    assert( allocator.largest_free_block() == 65536 );
+
+    // a count whose byte size overflows is refused, not wrapped
+    {
+        buddy_allocator<long, 8, 16, 4> longs(region, sizeof(region));
+        assert( longs.allocate(SIZE_MAX / sizeof(long) + 2) == nullptr );
+        assert( longs.allocate(SIZE_MAX) == nullptr );
+        long *l = longs.allocate(1);
+        longs.deallocate(l, SIZE_MAX / sizeof(long) + 2);
+        assert( longs.free_bytes() == sizeof(region) - 256 );
+        longs.deallocate(l, 1);
+        assert( longs.free_bytes() == sizeof(region) );
+    }
+    return 0;
+}
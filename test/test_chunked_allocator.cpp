@@ -0,0 +1,94 @@
+#include "chunked_allocator.h"
+#include "tlsf_allocator.h"
+#include "cassert"
+#include "set"
+
+using namespace std;
+using namespace kcore;
+
+struct message {
+    long id;
+    char body[40];
+};
+
+alignas(16) static unsigned char region[1 << 16];
+
+int main() {
+    tlsf_allocator<unsigned char> heap(region, sizeof(region));
+    size_t heap_free = heap.free_bytes();
+    {
+        chunked_allocator<message, 8, decltype(heap), 4> pool(heap, 1);
+        assert( pool.block_count() == 1 );
+        assert( pool.available_count() == 8 );
+
+        // past the first block the pool grows instead of failing
+        message *all[32];
+        set<message *> seen;
+        for(int i = 0; i < 32; ++i) {
+            all[i] = pool.allocate();
+            assert( all[i] != nullptr );
+            assert( pool.has(all[i]) );
+            seen.insert(all[i]);
+        }
+        assert( seen.size() == 32 );
+        assert( pool.block_count() == 4 );
+        assert( pool.available_count() == 0 );
+        assert( pool.allocate() == nullptr );
+
+        message outside;
+        assert( !pool.has(&outside) );
+        assert( pool.deallocate(&outside) == -1 );
+
+        // a freed slot is reused first
+        assert( pool.deallocate(all[13]) == 0 );
+        assert( pool.allocate() == all[13] );
+
+        // freeing a slot twice is refused, even with its block still in
+        // use, and the slot is not handed out twice
+        assert( pool.deallocate(all[13]) == 0 );
+        assert( pool.deallocate(all[13]) == -1 );
+        assert( pool.deallocate(reinterpret_cast<message *>(
+            reinterpret_cast<char *>(all[12]) + 1)) == -1 );
+        assert( pool.available_count() == 1 );
+        assert( pool.allocate() == all[13] );
+        assert( pool.allocate() == nullptr );
+
+        // emptied blocks beyond keep_empty go back upstream
+        for(int i = 0; i < 24; ++i) {
+            assert( pool.deallocate(all[i]) == 0 );
+        }
+        assert( pool.block_count() == 2 );
+        for(int i = 0; i < 24; ++i) {
+            assert( pool.has(all[i]) == (i < 8) );
+        }
+        assert( pool.available_count() == 8 );
+        for(int i = 24; i < 32; ++i) {
+            assert( pool.has(all[i]) );
+        }
+
+        // and are taken again when needed
+        for(int i = 0; i < 16; ++i) {
+            all[i] = pool.allocate();
+            assert( all[i] != nullptr && pool.has(all[i]) );
+        }
+        assert( pool.block_count() == 3 );
+    }
+    // all blocks are returned when the pool goes away
+    assert( heap.free_bytes() == heap_free );
+
+    // without a threshold empty blocks are kept
+    {
+        chunked_allocator<message, 8, decltype(heap)> pool(heap);
+        message *all[20];
+        for(int i = 0; i < 20; ++i) {
+            all[i] = pool.allocate();
+        }
+        for(int i = 0; i < 20; ++i) {
+            assert( pool.deallocate(all[i]) == 0 );
+        }
+        assert( pool.block_count() == 3 );
+        assert( pool.available_count() == 24 );
+    }
+    assert( heap.free_bytes() == heap_free );
+    return 0;
+}
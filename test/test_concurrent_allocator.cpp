@@ -0,0 +1,132 @@
+#include "allocator.h"
+#include "concurrent_allocator.h"
+#include "atomic"
+#include "cassert"
+#include "climits"
+#include "thread"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires kcore::allocator<Alloc> && extend_allocator<Alloc>
+void test(Alloc &allocator) {
+    int *a = allocator.allocate();
+    assert( allocator.available_count() == 7 );
+    assert( allocator.has(a) == true );
+    assert( allocator.deallocate(a) == 0);
+}
+
+// Every thread stamps the slots it owns and checks nobody else wrote to
+// them before giving them back; a slot handed out twice breaks the stamp.
+void stress() {
+    constexpr int threads = 8;
+    constexpr int rounds = 20000;
+    static concurrent_allocator<long, 64> pool;
+    atomic<int> failures(0);
+
+    vector<thread> workers;
+    for(int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            long *held[4];
+            for(int r = 0; r < rounds; ++r) {
+                // odd rounds use the batch interface
+                int n = 0;
+                if(r & 1) {
+                    n = static_cast<int>(pool.allocate_n(held, 4));
+                } else {
+                    for(; n < 4; ++n) {
+                        held[n] = pool.allocate();
+                        if(held[n] == nullptr) {
+                            break;
+                        }
+                    }
+                }
+                for(int i = 0; i < n; ++i) {
+                    *held[i] = (long(t) << 32) | r;
+                }
+                for(int i = 0; i < n; ++i) {
+                    if(*held[i] != ((long(t) << 32) | r)) {
+                        ++failures;
+                    }
+                }
+                if(r & 1) {
+                    if(pool.deallocate_n(held, n) != size_t(n)) {
+                        ++failures;
+                    }
+                } else {
+                    for(int i = 0; i < n; ++i) {
+                        pool.deallocate(held[i]);
+                    }
+                }
+            }
+        });
+    }
+    for(auto &w : workers) {
+        w.join();
+    }
+    assert( failures == 0 );
+    assert( pool.available_count() == 64 );
+
+    // the stack still holds every slot exactly once
+    long *all[64];
+    for(int i = 0; i < 64; ++i) {
+        all[i] = pool.allocate();
+        assert( all[i] != nullptr );
+        for(int j = 0; j < i; ++j) {
+            assert( all[i] != all[j] );
+        }
+    }
+    assert( pool.allocate() == nullptr );
+}
+
+int main() {
+    concurrent_allocator<int,8> allocator;
+    test(allocator);
+
+    int *a = allocator.allocate();
+    assert( allocator.deallocate(a) == 0 );
+    assert( allocator.deallocate(a) == 0 );
+    assert( allocator.available_count() == 8 );
+    int outside;
+    assert( allocator.deallocate(&outside) == -1 );
+
+    int *b = allocator.allocate();
+    assert( allocator.retain(b) == 2 );
+    int disposed = 0;
+    assert( allocator.release(b, [&](int *) { ++disposed; }) == 1 );
+    assert( allocator.release(b, [&](int *) { ++disposed; }) == 0 );
+    assert( disposed == 1 );
+    assert( allocator.retain(b) == -1 );
+    assert( allocator.available_count() == 8 );
+
+    b = allocator.allocate();
+    for(int i = 2; i <= UCHAR_MAX; ++i) {
+        assert( allocator.retain(b) == i );
+    }
+    assert( allocator.retain(b) == -1 );
+    for(int i = UCHAR_MAX - 1; i >= 0; --i) {
+        assert( allocator.deallocate(b) == i );
+    }
+    assert( allocator.available_count() == 8 );
+
+    concurrent_allocator<int,2,uint16_t> counted;
+    b = counted.allocate();
+    for(int i = 2; i <= UINT16_MAX; ++i) {
+        assert( counted.retain(b) == i );
+    }
+    assert( counted.retain(b) == -1 );
+    for(int i = UINT16_MAX - 1; i >= 0; --i) {
+        assert( counted.deallocate(b) == i );
+    }
+
+    int *got[8];
+    assert( allocator.allocate_n(got, 10) == 8 );
+    assert( allocator.available_count() == 0 );
+    assert( allocator.deallocate_n(got, 8) == 8 );
+    assert( allocator.deallocate_n(got, 8) == 0 );
+    assert( allocator.available_count() == 8 );
+
+    stress();
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "handle_allocator.h"
+#include "allocator.h"
+#include "cassert"
+#include "cstdint"
+
+using namespace std;
+using namespace kcore;
+
+struct node {
+    int value;
+    long pad;
+};
+
+// the handle width follows N, always leaving 12 generation bits
+static_assert( sizeof(handle_allocator<node, 16>::handle) == 2 );
+static_assert( handle_allocator<node, 16>::generation_bits == 12 );
+static_assert( sizeof(handle_allocator<node, 17>::handle) == 4 );
+static_assert( handle_allocator<node, 1024>::generation_bits == 22 );
+static_assert( sizeof(handle_allocator<node, 4, uint64_t>::handle) == 8 );
+static_assert( kcore::allocator<handle_allocator<node, 4>> );
+
+int main() {
+    handle_allocator<node, 4> pool;
+    auto h = pool.allocate_handle();
+    assert( h );
+    node *p = pool.resolve(h);
+    assert( p != nullptr && pool.has(p) );
+    p->value = 7;
+    assert( pool.handle_of(p) == h );
+    assert( pool.available_count() == 3 );
+
+    // a freed slot invalidates its handles, and stays invalid after reuse
+    assert( pool.deallocate(h) == 0 );
+    assert( pool.resolve(h) == nullptr );
+    assert( pool.deallocate(h) == -1 );
+    auto again = pool.allocate_handle();
+    assert( pool.resolve(again) == p );
+    assert( again != h );
+    assert( pool.resolve(h) == nullptr );
+
+    // null and out-of-range handles resolve to nothing
+    assert( pool.resolve(handle_allocator<node, 4>::handle{}) == nullptr );
+    assert( !pool.handle_of(p + 100) );
+
+    // exhaustion and the pointer interface
+    node *a = pool.allocate();
+    node *b = pool.allocate();
+    node *c = pool.allocate();
+    assert( a && b && c );
+    assert( !pool.allocate_handle() );
+    assert( pool.deallocate(b) == 0 );
+    assert( pool.deallocate(b) == -1 );
+    assert( !pool.handle_of(b) );
+    node outside;
+    assert( pool.deallocate(&outside) == -1 );
+    assert( pool.available_count() == 1 );
+
+    // many reuses of one slot never resolve a handle from an earlier turn
+    handle_allocator<node, 1> one;
+    auto first = one.allocate_handle();
+    one.deallocate(first);
+    for(int i = 0; i < 30; ++i) {
+        auto next = one.allocate_handle();
+        assert( one.resolve(first) == nullptr );
+        assert( one.resolve(next) != nullptr );
+        one.deallocate(next);
+    }
+
+    // Generations wrap: a slot reused 2^(generation_bits - 1) times hands
+    // out the first handle again, as documented, and not a turn sooner.
+    using small = handle_allocator<node, 16>;
+    static small pool16;
+    auto h0 = pool16.allocate_handle();
+    pool16.deallocate(h0);
+    const long wrap = 1L << (small::generation_bits - 1);
+    for(long turn = 1; turn < wrap; ++turn) {
+        auto next = pool16.allocate_handle();
+        assert( next != h0 && pool16.resolve(h0) == nullptr );
+        pool16.deallocate(next);
+    }
+    auto aliased = pool16.allocate_handle();
+    assert( aliased == h0 && pool16.resolve(h0) != nullptr );
+    return 0;
+}
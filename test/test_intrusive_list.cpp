@@ -0,0 +1,112 @@
+#include "intrusive_list.h"
+#include "typed_allocator.h"
+#include "cassert"
+#include "iterator"
+#include "type_traits"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+struct by_age;
+struct by_use;
+
+// one object on three lists at once
+struct entry : slist_hook<>, list_hook<by_age>, list_hook<by_use> {
+    int key;
+};
+
+using age_list = intrusive_list<entry, by_age>;
+using use_list = intrusive_list<entry, by_use>;
+
+static_assert(is_base_of<forward_iterator_tag,
+        iterator_traits<intrusive_slist<entry>::iterator>::iterator_category>::value, "");
+static_assert(is_base_of<bidirectional_iterator_tag,
+        iterator_traits<age_list::iterator>::iterator_category>::value, "");
+static_assert(is_same<age_list::iterator::rvalue_reference, entry &&>::value, "");
+
+template<class L>
+vector<int> keys(L &l) {
+    vector<int> out;
+    for(entry &e : l) {
+        out.push_back(e.key);
+    }
+    return out;
+}
+
+int main() {
+    typed_allocator<entry, 8> pool;
+    entry *e[8];
+    for(int i = 0; i < 8; ++i) {
+        e[i] = pool.allocate();
+        assert( e[i] != nullptr );
+        new (e[i]) entry();
+        e[i]->key = i;
+    }
+
+    intrusive_slist<entry> free_list;
+    assert( free_list.empty() && free_list.pop_front() == nullptr );
+    free_list.push_back(*e[1]);
+    free_list.push_front(*e[0]);
+    free_list.push_back(*e[3]);
+    free_list.insert_after(*e[1], *e[2]);
+    assert( (keys(free_list) == vector<int>{0, 1, 2, 3}) );
+    assert( free_list.remove(*e[3]) );
+    assert( !free_list.remove(*e[3]) );
+    assert( &free_list.back() == e[2] );
+    free_list.push_back(*e[4]);
+    assert( (keys(free_list) == vector<int>{0, 1, 2, 4}) );
+    assert( free_list.pop_front() == e[0] );
+    assert( free_list.size() == 3 && &free_list.front() == e[1] );
+    free_list.clear();
+    assert( free_list.empty() );
+
+    age_list ages;
+    use_list uses;
+    for(int i = 0; i < 5; ++i) {
+        ages.push_back(*e[i]);
+        uses.push_front(*e[i]);
+    }
+    assert( (keys(ages) == vector<int>{0, 1, 2, 3, 4}) );
+    assert( (keys(uses) == vector<int>{4, 3, 2, 1, 0}) );
+
+    // touching an entry moves it on one list and leaves the other alone
+    uses.remove(*e[2]);
+    uses.push_front(*e[2]);
+    assert( (keys(uses) == vector<int>{2, 4, 3, 1, 0}) );
+    assert( (keys(ages) == vector<int>{0, 1, 2, 3, 4}) );
+
+    // copies of a linked entry start out unlinked, and assigning over a
+    // linked entry keeps its place
+    entry copy = *e[3];
+    assert( copy.key == 3 );
+    assert( !static_cast<list_hook<by_age> &>(copy).linked() );
+    assert( static_cast<slist_hook<> &>(copy).next == nullptr );
+    copy.key = 30;
+    *e[3] = copy;
+    assert( e[3]->key == 30 && static_cast<list_hook<by_age> &>(*e[3]).linked() );
+    assert( (keys(ages) == vector<int>{0, 1, 2, 30, 4}) );
+    e[3]->key = 3;
+
+    auto it = ages.erase(ages.iterator_to(*e[1]));
+    assert( &*it == e[2] );
+    assert( !static_cast<list_hook<by_age> &>(*e[1]).linked() );
+    assert( static_cast<list_hook<by_use> &>(*e[1]).linked() );
+    ages.insert(it, *e[7]);
+    assert( (keys(ages) == vector<int>{0, 7, 2, 3, 4}) );
+
+    auto last = ages.end();
+    --last;
+    assert( last->key == 4 );
+    assert( (--last)->key == 3 );
+    assert( ages.pop_back() == e[4] && ages.pop_front() == e[0] );
+    assert( ages.size() == 3 );
+    ages.clear();
+    uses.clear();
+    assert( ages.empty() && uses.empty() && ages.begin() == ages.end() );
+
+    for(int i = 0; i < 8; ++i) {
+        assert( pool.deallocate(e[i]) == 0 );
+    }
+    return 0;
+}
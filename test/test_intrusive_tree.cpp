@@ -0,0 +1,155 @@
+#include "intrusive_tree.h"
+#include "algorithm"
+#include "cassert"
+#include "cstdlib"
+#include "iterator"
+#include "set"
+#include "type_traits"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+struct item : tree_hook<> {
+    int key;
+    int id;
+};
+
+struct by_key {
+    bool operator()(const item &a, const item &b) const { return a.key < b.key; }
+    bool operator()(const item &a, int k) const { return a.key < k; }
+    bool operator()(int k, const item &b) const { return k < b.key; }
+};
+
+using tree = intrusive_tree<item, by_key>;
+
+static_assert(is_base_of<bidirectional_iterator_tag,
+        iterator_traits<tree::iterator>::iterator_category>::value, "");
+static_assert(is_same<decltype(*declval<tree::iterator &>()), item &>::value, "");
+static_assert(is_same<decltype(--declval<tree::iterator &>()), tree::iterator &>::value, "");
+static_assert(is_same<tree::iterator::rvalue_reference, item &&>::value, "");
+
+// returns the height below h, checking links, ordering and AVL balance
+static int check(const tree_hook<> *h, const tree_hook<> *parent) {
+    if(h == nullptr) {
+        return 0;
+    }
+    assert( h->parent == parent );
+    int l = check(h->left, h);
+    int r = check(h->right, h);
+    assert( l - r <= 1 && r - l <= 1 );
+    assert( h->height == (l > r ? l : r) + 1 );
+    const item *self = static_cast<const item *>(h);
+    assert( h->left == nullptr || static_cast<const item *>(h->left)->key <= self->key );
+    assert( h->right == nullptr || self->key <= static_cast<const item *>(h->right)->key );
+    return h->height;
+}
+
+static const tree_hook<> *root_of(tree &t) {
+    if(t.empty()) {
+        return nullptr;
+    }
+    const tree_hook<> *h = &*t.begin();
+    while(h->parent != nullptr) {
+        h = h->parent;
+    }
+    return h;
+}
+
+int main() {
+    const int n = 2000;
+    vector<item> items(n);
+    multiset<int> model;
+    tree t;
+    assert( t.empty() && t.begin() == t.end() );
+
+    srand(7);
+    for(int i = 0; i < n; ++i) {
+        items[i].key = rand() % 500;
+        items[i].id = i;
+    }
+
+    // in-order insertion is the degenerate case for an unbalanced tree
+    for(int i = 0; i < 64; ++i) {
+        items[i].key = i;
+        t.insert(items[i]);
+        model.insert(i);
+    }
+    assert( check(root_of(t), nullptr) <= 7 );
+
+    for(int round = 0; round < 20000; ++round) {
+        item &it = items[rand() % n];
+        if(static_cast<tree_hook<> &>(it).height == 0) {
+            t.insert(it);
+            model.insert(it.key);
+        } else {
+            t.remove(it);
+            model.erase(model.find(it.key));
+        }
+        if(round % 1000 == 0) {
+            check(root_of(t), nullptr);
+        }
+    }
+    check(root_of(t), nullptr);
+    assert( t.size() == model.size() );
+    assert( equal(model.begin(), model.end(), t.begin(), t.end(),
+                [](int k, const item &i) { return k == i.key; }) );
+    // and backwards, starting from --end()
+    auto m = model.rbegin();
+    for(auto i = t.end(); i != t.begin(); ++m) {
+        --i;
+        assert( i->key == *m );
+    }
+
+    for(int k = -1; k < 502; ++k) {
+        auto lb = t.lower_bound(k);
+        auto mlb = model.lower_bound(k);
+        assert( (lb == t.end()) == (mlb == model.end()) );
+        if(lb != t.end()) {
+            assert( lb->key == *mlb );
+        }
+        auto f = t.find(k);
+        assert( (f == t.end()) == (model.count(k) == 0) );
+        assert( f == t.end() || f->key == k );
+    }
+
+    // equal keys keep insertion order
+    tree dup;
+    item a, b, c;
+    a.key = b.key = c.key = 5;
+    a.id = 0; b.id = 1; c.id = 2;
+    dup.insert(a);
+    dup.insert(b);
+    dup.insert(c);
+    auto e = dup.begin();
+    assert( (e++)->id == 0 && (e++)->id == 1 && e->id == 2 );
+    assert( dup.erase(dup.iterator_to(b))->id == 2 );
+    assert( dup.find(5)->id == 0 );
+
+    // a copy of a linked element is not in the tree
+    item copy = b;
+    copy = a;
+    assert( copy.key == 5 && static_cast<tree_hook<> &>(copy).height == 0 );
+    assert( static_cast<tree_hook<> &>(copy).parent == nullptr );
+
+    dup.clear();
+    t.clear();
+    assert( t.empty() && t.size() == 0 && dup.empty() );
+    for(const item &i : items) {
+        const tree_hook<> &h = i;
+        assert( h.parent == nullptr && h.left == nullptr && h.right == nullptr && h.height == 0 );
+    }
+
+    // destroying a tree unlinks what is still in it
+    {
+        tree scoped;
+        for(int i = 0; i < 100; ++i) {
+            scoped.insert(items[i]);
+        }
+    }
+    for(int i = 0; i < 100; ++i) {
+        const tree_hook<> &h = items[i];
+        assert( h.parent == nullptr && h.left == nullptr && h.right == nullptr && h.height == 0 );
+    }
+    return 0;
+}
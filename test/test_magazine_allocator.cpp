@@ -0,0 +1,111 @@
+#include "allocator.h"
+#include "concurrent_allocator.h"
+#include "magazine_allocator.h"
+#include "typed_allocator.h"
+#include "cassert"
+#include "mutex"
+#include "thread"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires kcore::allocator<Alloc> && extend_allocator<Alloc>
+void test(Alloc &allocator) {
+    int *a = allocator.allocate();
+    assert( allocator.available_count() == 7 );
+    assert( allocator.has(a) == true );
+    assert( allocator.deallocate(a) == 0);
+}
+
+// Producer allocates through its magazine, consumer frees through its own.
+void cross_thread() {
+    static concurrent_allocator<long, 256> pool;
+    constexpr int items = 100000;
+    mutex lock;
+    vector<long *> queue;
+
+    thread producer([&] {
+        magazine_allocator<concurrent_allocator<long, 256>, 16> cache(pool);
+        for(int i = 0; i < items; ++i) {
+            long *p;
+            while((p = cache.allocate()) == nullptr) {
+                this_thread::yield();
+            }
+            *p = i;
+            lock_guard<mutex> guard(lock);
+            queue.push_back(p);
+        }
+    });
+    thread consumer([&] {
+        magazine_allocator<concurrent_allocator<long, 256>, 16> cache(pool);
+        int seen = 0;
+        long expect = 0;
+        while(seen < items) {
+            vector<long *> batch;
+            {
+                lock_guard<mutex> guard(lock);
+                batch.swap(queue);
+            }
+            for(long *p : batch) {
+                assert( *p == expect++ );
+                assert( cache.deallocate(p) == 0 );
+                ++seen;
+            }
+            // give objects back to the pool so the producer can reuse them
+            cache.drain();
+        }
+    });
+    producer.join();
+    consumer.join();
+    assert( pool.available_count() == 256 );
+}
+
+int main() {
+    typed_allocator<int,8> pool;
+    {
+        magazine_allocator<typed_allocator<int,8>, 4> allocator(pool);
+        test(allocator);
+
+        // a refill takes half a magazine from the pool
+        int *a = allocator.allocate();
+        assert( allocator.cached_count() == 1 );
+        assert( pool.available_count() == 6 );
+
+        // a full magazine flushes half of itself before caching more
+        int *held[7];
+        held[0] = a;
+        for(int i = 1; i < 7; ++i) {
+            held[i] = allocator.allocate();
+            assert( held[i] != nullptr );
+        }
+        assert( allocator.allocate() != nullptr );
+        assert( allocator.allocate() == nullptr );
+        for(int i = 0; i < 7; ++i) {
+            assert( allocator.deallocate(held[i]) == 0 );
+        }
+        assert( allocator.cached_count() <= 4 );
+        assert( allocator.available_count() == 7 );
+
+        int outside;
+        assert( allocator.deallocate(&outside) == -1 );
+    }
+    // destroying the magazine hands everything back except the leaked slot
+    assert( pool.available_count() == 7 );
+
+    // batches go through the magazine and on to the pool's batch interface
+    typed_allocator<int,64> big;
+    {
+        magazine_allocator<typed_allocator<int,64>, 8> allocator(big);
+        static_assert( batch_allocator<decltype(allocator)> );
+        int *got[64];
+        assert( allocator.allocate_n(got, 20) == 20 );
+        assert( big.available_count() == 64 - 20 - allocator.cached_count() );
+        assert( allocator.deallocate_n(got, 20) == 20 );
+        assert( allocator.available_count() == 64 );
+    }
+    assert( big.available_count() == 64 );
+
+    cross_thread();
+    return 0;
+}
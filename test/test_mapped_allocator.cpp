@@ -0,0 +1,112 @@
+#include "mapped_allocator.h"
+#include "allocator.h"
+#include "cassert"
+#include "cstdio"
+#include "cstdlib"
+#include "new"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+struct entry {
+    long key;
+    long value;
+};
+
+static_assert( kcore::allocator<mapped_allocator<entry, 16>> );
+static_assert( extend_allocator<mapped_allocator<entry, 16>> );
+
+int main() {
+    char path[] = "/tmp/test_mapped_allocatorXXXXXX";
+    int fd = mkstemp(path);
+    assert( fd >= 0 );
+    close(fd);
+
+    size_t kept, last_freed;
+    {
+        mapped_allocator<entry, 16> pool(path);
+        assert( pool.is_open() && !pool.attached() );
+        entry *all[16];
+        for(int i = 0; i < 16; ++i) {
+            all[i] = pool.allocate();
+            *all[i] = entry{i, i * 10};
+        }
+        assert( pool.allocate() == nullptr );
+        for(int i = 0; i < 16; i += 2) {
+            assert( pool.deallocate(all[i]) == 0 );
+        }
+        assert( pool.deallocate(all[0]) == -1 );
+        assert( pool.available_count() == 8 );
+        kept = pool.offset_of(all[5]);
+        last_freed = pool.offset_of(all[14]);
+        assert( pool.at(kept) == all[5] );
+    }
+
+    // a clean close is picked up again, wherever the file gets mapped
+    {
+        mapped_allocator<entry, 16> pool(path);
+        assert( pool.attached() );
+        assert( pool.available_count() == 8 );
+        assert( pool.at(kept)->key == 5 && pool.at(kept)->value == 50 );
+        long keys = 0;
+        int live = 0;
+        pool.for_each([&](entry *e) {
+            keys += e->key;
+            ++live;
+        });
+        assert( live == 8 && keys == 1 + 3 + 5 + 7 + 9 + 11 + 13 + 15 );
+        // the free list survived too
+        entry *e = pool.allocate();
+        assert( e != nullptr && pool.offset_of(e) == last_freed );
+    }
+
+    // a pool that was never closed (crash) is not trusted
+    {
+        alignas(mapped_allocator<entry, 16>) unsigned char raw[sizeof(mapped_allocator<entry, 16>)];
+        auto crashed = new (raw) mapped_allocator<entry, 16>(path);
+        assert( crashed->attached() );
+        crashed->allocate();
+        mapped_allocator<entry, 16> pool(path);
+        assert( !pool.attached() );
+        assert( pool.available_count() == 16 );
+    }
+
+    // neither is one of another shape
+    {
+        mapped_allocator<entry, 8> pool(path);
+        assert( !pool.attached() );
+    }
+    // sync() makes a crash recoverable until the next change
+    {
+        alignas(mapped_allocator<entry, 16>) unsigned char raw[sizeof(mapped_allocator<entry, 16>)];
+        auto crashed = new (raw) mapped_allocator<entry, 16>(path);
+        assert( !crashed->attached() );
+        crashed->allocate();
+        crashed->sync();
+        mapped_allocator<entry, 16> again(path);
+        assert( again.attached() && again.available_count() == 15 );
+    }
+
+    // flipped bits in the occupancy table fail the checksum
+    {
+        mapped_allocator<entry, 16> pool(path);
+        pool.allocate();
+    }
+    {
+        FILE *f = fopen(path, "r+b");
+        assert( f != nullptr );
+        fseek(f, 64, SEEK_SET);
+        fputc(0x7f, f);
+        fclose(f);
+        mapped_allocator<entry, 16> pool(path);
+        assert( !pool.attached() );
+    }
+
+    mapped_allocator<entry, 16> nowhere("/nonexistent/dir/pool");
+    assert( !nowhere.is_open() );
+    assert( nowhere.allocate() == nullptr && nowhere.available_count() == 0 );
+
+    unlink(path);
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "page_region.h"
+#include "tlsf_allocator.h"
+#include "buddy_allocator.h"
+#include "cassert"
+#include "cstdint"
+#include "cstring"
+#include "string_view"
+
+using namespace std;
+using namespace kcore;
+
+int main() {
+    constexpr size_t bytes = 6 << 20;
+
+    // whatever the machine offers, the region is usable and says what it is
+    {
+        page_region region(bytes, true);
+        assert( region.backing() != page_backing::none );
+        assert( region.data() != nullptr && region.size() >= bytes );
+        if(region.backing() != page_backing::normal) {
+            assert( reinterpret_cast<uintptr_t>(region.data()) % page_region::huge_page == 0 );
+        }
+        assert( region.huge_bytes() <= region.size() );
+        memset(region.data(), 0xa5, region.size());
+        assert( static_cast<unsigned char *>(region.data())[region.size() - 1] == 0xa5 );
+
+        // pools taking a region plug it in directly
+        tlsf_allocator<char> heap(region.data(), region.size());
+        char *p = heap.allocate(1 << 20);
+        assert( p != nullptr && heap.has(p) );
+        heap.deallocate(p, 1 << 20);
+    }
+
+    // asking for less skips the huge page tiers
+    {
+        page_region region(bytes, false, page_backing::normal);
+        assert( region.backing() == page_backing::normal );
+        assert( region.size() == bytes );
+        assert( region.huge_bytes() == 0 );
+        buddy_allocator<char, 12, 20, 64> buddy(region.data(), region.size());
+        assert( buddy.allocate(4096) != nullptr );
+    }
+    {
+        page_region region(bytes, true, page_backing::transparent);
+        assert( region.backing() == page_backing::transparent ||
+            region.backing() == page_backing::normal );
+    }
+
+    page_region empty(0);
+    assert( empty.backing() == page_backing::none && empty.data() == nullptr );
+    assert( backing_name(page_backing::hugetlb) == string_view("hugetlb") );
+    return 0;
+}
@@ -0,0 +1,84 @@
+#include "pool_allocator.h"
+#include "size_class_allocator.h"
+#include "tlsf_allocator.h"
+#include "typed_allocator.h"
+#include "cassert"
+#include "list"
+#include "map"
+#include "memory_resource"
+#include "new"
+#include "vector"
+
+using namespace std;
+using namespace kcore;
+
+alignas(16) static unsigned char region[1 << 16];
+
+struct alignas(16) node_slot {
+    unsigned char data[64];
+};
+
+int main() {
+    tlsf_allocator<char> heap(region, sizeof(region));
+    size_t initial = heap.free_bytes();
+    {
+        using alloc = pool_allocator<int, tlsf_allocator<char>>;
+        static_assert( sizeof(alloc) == sizeof(void *) );
+        vector<int, alloc> v{alloc(heap)};
+        for(int i = 0; i < 1000; ++i) {
+            v.push_back(i);
+        }
+        assert( heap.has(reinterpret_cast<char *>(v.data())) );
+        assert( heap.free_bytes() < initial );
+
+        // rebinding keeps the same pool
+        using pair_alloc = pool_allocator<pair<const int, int>, tlsf_allocator<char>>;
+        map<int, int, less<int>, pair_alloc> m{pair_alloc(heap)};
+        m[1] = 2;
+        assert( alloc(heap) == pair_alloc(heap) );
+        assert( allocator_traits<alloc>::rebind_alloc<long>(alloc(heap)) == alloc(heap) );
+    }
+    assert( heap.free_bytes() == initial );
+
+    // a single-object pool serves list nodes but nothing larger than a slot
+    typed_allocator<node_slot, 16> nodes;
+    {
+        list<int, pool_allocator<int, typed_allocator<node_slot, 16>>> l{
+            pool_allocator<int, typed_allocator<node_slot, 16>>(nodes)};
+        for(int i = 0; i < 16; ++i) {
+            l.push_back(i);
+        }
+        assert( nodes.available_count() == 0 );
+        bool threw = false;
+        try {
+            l.push_back(16);
+        } catch(const bad_alloc &) {
+            threw = true;
+        }
+        assert( threw );
+
+        pool_allocator<char, typed_allocator<node_slot, 16>> bytes(nodes);
+        threw = false;
+        try {
+            bytes.allocate(65);
+        } catch(const bad_alloc &) {
+            threw = true;
+        }
+        assert( threw );
+    }
+    assert( nodes.available_count() == 16 );
+
+    // memory_resource bridge for std::pmr containers
+    size_class_allocator<char, 8, 8, 8, 8, 8, 8> classes;
+    pool_resource<size_class_allocator<char, 8, 8, 8, 8, 8, 8>> resource(classes);
+    {
+        pmr::vector<int> v(&resource);
+        v.reserve(100);
+        assert( classes.stats(5).in_use == 1 );
+        pmr::vector<int> w(&resource);
+        assert( v.get_allocator() == w.get_allocator() );
+    }
+    assert( classes.stats(5).in_use == 0 );
+    assert( !resource.is_equal(*pmr::new_delete_resource()) );
+    return 0;
+}
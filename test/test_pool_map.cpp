@@ -0,0 +1,78 @@
+#include "pool_map.h"
+#include "typed_allocator.h"
+#include "bitmap_allocator.h"
+#include "size_class_allocator.h"
+#include "cassert"
+
+using namespace std;
+using namespace kcore;
+
+struct sample {
+    long values[4];
+};
+
+// small pools packed into the same pages
+static registered<typed_allocator<int, 4>> ints;
+static registered<bitmap_allocator<short, 64>> shorts;
+static registered<typed_allocator<sample, 8>> samples;
+// and one spanning many pages
+static registered<typed_allocator<sample, 4096>> big;
+
+// what a C callback holding only a void * would do
+static void on_done(void *p) {
+    assert( kcore::deallocate(p) == 0 );
+}
+
+int main() {
+    int *i = ints.allocate();
+    short *s = shorts.allocate();
+    sample *a = samples.allocate();
+    sample *b[4096];
+    for(int k = 0; k < 4096; ++k) {
+        b[k] = big.allocate();
+    }
+    assert( object_size(i) == sizeof(int) );
+    assert( object_size(s) == sizeof(short) );
+    assert( object_size(b[4000]) == sizeof(sample) );
+
+    on_done(i);
+    on_done(s);
+    on_done(a);
+    for(int k = 0; k < 4096; ++k) {
+        on_done(b[k]);
+    }
+    assert( ints.available_count() == 4 );
+    assert( shorts.available_count() == 64 );
+    assert( samples.available_count() == 8 );
+    assert( big.available_count() == 4096 );
+
+    int outside;
+    assert( kcore::deallocate(&outside) == -1 );
+    assert( object_size(&outside) == 0 );
+    assert( kcore::deallocate(nullptr) == -1 );
+
+    // the entry goes away with the pool
+    void *stale;
+    {
+        registered<typed_allocator<int, 4>> scoped;
+        stale = scoped.allocate();
+        assert( object_size(stale) == sizeof(int) );
+    }
+    assert( kcore::deallocate(stale) == -1 );
+
+    // each size class is its own entry
+    {
+        auto heap = new registered<size_class_allocator<char, 4, 4, 4, 2>>;
+        char *small = heap->allocate(10);
+        char *large = heap->allocate(100);
+        assert( object_size(small) == 16 );
+        assert( object_size(large) == 128 );
+        assert( heap->stats(3).in_use == 1 );
+        assert( kcore::deallocate(large) == 0 );
+        assert( kcore::deallocate(small) == 0 );
+        assert( heap->stats(3).in_use == 0 && heap->stats(0).in_use == 0 );
+        delete heap;
+        assert( object_size(small) == 0 );
+    }
+    return 0;
+}
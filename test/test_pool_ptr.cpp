@@ -0,0 +1,140 @@
+#include "pool_ptr.h"
+#include "typed_allocator.h"
+#include "concurrent_allocator.h"
+#include "cassert"
+#include "climits"
+#include "csignal"
+#include "cstdint"
+#include "thread"
+#include "utility"
+#include "vector"
+#include "sys/wait.h"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+static int live = 0;
+
+struct frame {
+    int id;
+    long stamp;
+    frame(int id, long stamp) : id(id), stamp(stamp) { ++live; }
+    ~frame() { --live; }
+};
+
+static typed_allocator<frame, 4> frames;
+
+static concurrent_allocator<frame, 4> shared_frames;
+
+// consumers on several threads copy and drop the same frame
+static void shared_across_threads() {
+    {
+        auto origin = make_shared_pooled<frame, shared_frames>(9, 90L);
+        vector<thread> consumers;
+        for(int t = 0; t < 4; ++t) {
+            consumers.emplace_back([copy = origin]() mutable {
+                for(int i = 0; i < 10000; ++i) {
+                    auto again = copy;
+                    assert( again->id == 9 );
+                }
+            });
+        }
+        for(auto &c : consumers) {
+            c.join();
+        }
+        assert( live == 1 );
+        assert( shared_frames.available_count() == 3 );
+    }
+    assert( live == 0 );
+    assert( shared_frames.available_count() == 4 );
+}
+
+// A copy cannot fail quietly: past the pool's count limit it aborts.
+static void copy_past_limit() {
+    pid_t child = fork();
+    assert( child >= 0 );
+    if(child == 0) {
+        typed_allocator<frame, 1> one;
+        auto origin = make_shared_pooled<frame>(one, 1, 10L);
+        vector<decltype(origin)> copies;
+        copies.reserve(CHAR_MAX);
+        for(int i = 1; i < CHAR_MAX; ++i) {
+            copies.push_back(origin);
+            if(!copies.back()) {
+                _exit(1);
+            }
+        }
+        copies.push_back(origin);
+        _exit(2);
+    }
+    int status;
+    assert( waitpid(child, &status, 0) == child );
+    assert( WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT );
+}
+
+int main() {
+    typed_allocator<frame, 2> pool;
+    {
+        auto a = make_pooled<frame>(pool, 1, 10L);
+        assert( a && a->id == 1 && (*a).stamp == 10 );
+        assert( live == 1 );
+        assert( pool.available_count() == 1 );
+
+        auto b = make_pooled<frame>(pool, 2, 20L);
+        auto c = make_pooled<frame>(pool, 3, 30L);
+        assert( !c );
+        assert( live == 2 );
+
+        // moving transfers ownership, the source ends up empty
+        auto moved = std::move(a);
+        assert( !a && moved->id == 1 );
+        b = std::move(moved);
+        assert( live == 1 );
+        assert( b->id == 1 );
+        assert( pool.available_count() == 1 );
+
+        b.reset();
+        assert( live == 0 );
+        assert( pool.available_count() == 2 );
+    }
+    assert( pool.available_count() == 2 );
+
+    // handles into a static pool are a bare pointer
+    static_assert( sizeof(decltype(make_pooled<frame, frames>(0, 0L))) == sizeof(frame *) );
+    static_assert( sizeof(decltype(make_pooled<frame>(pool, 0, 0L))) == 2 * sizeof(void *) );
+    {
+        auto s = make_pooled<frame, frames>(7, 70L);
+        assert( s->id == 7 );
+        assert( frames.available_count() == 3 );
+        frame *raw = s.release();
+        assert( frames.available_count() == 3 );
+        pool_ptr<frame, static_pool_deleter<frames>> again(raw);
+        assert( again.get_deleter().upstream() == &frames );
+    }
+    assert( frames.available_count() == 4 );
+    assert( live == 0 );
+
+    // shared handles: the pool's slot count is the reference count
+    static_assert( sizeof(decltype(make_shared_pooled<frame, frames>(0, 0L))) == sizeof(frame *) );
+    {
+        auto first = make_shared_pooled<frame>(pool, 4, 40L);
+        {
+            auto second = first;
+            auto third = second;
+            assert( third == first && third->id == 4 );
+            assert( pool.available_count() == 1 );
+            first.reset();
+            assert( live == 1 );
+            first = std::move(third);
+            assert( !third );
+        }
+        assert( live == 1 );
+    }
+    assert( live == 0 );
+    assert( pool.available_count() == 2 );
+
+    shared_across_threads();
+    copy_past_limit();
+    return 0;
+}
@@ -0,0 +1,182 @@
+#include "shm_allocator.h"
+#include "allocator.h"
+#include "atomic"
+#include "cassert"
+#include "csignal"
+#include "cstdio"
+#include "sys/mman.h"
+#include "sys/wait.h"
+#include "unistd.h"
+
+using namespace std;
+using namespace kcore;
+
+struct sample {
+    long seq;
+    long sum;
+    int values[12];
+};
+
+constexpr int slots = 64;
+constexpr int messages = 20000;
+
+using pool_type = shm_allocator<sample, slots>;
+
+static_assert( kcore::allocator<pool_type> && batch_allocator<pool_type> && extend_allocator<pool_type> );
+
+static auto fill(sample *s, long seq) -> void {
+    s->seq = seq;
+    s->sum = 0;
+    for(int i = 0; i < 12; ++i) {
+        s->values[i] = int(seq * 31 + i);
+        s->sum += s->values[i];
+    }
+}
+
+static auto check(const sample *s, long seq) -> bool {
+    long sum = 0;
+    for(int i = 0; i < 12; ++i) {
+        sum += s->values[i];
+    }
+    return s->seq == seq && s->sum == sum;
+}
+
+// The parent fills samples and hands their offsets to a child, which maps
+// the segment again at its own address, checks each sample and frees it.
+static void handoff(int fd) {
+    int pipe_fds[2];
+    assert( pipe(pipe_fds) == 0 );
+    pid_t child = fork();
+    assert( child >= 0 );
+    if(child == 0) {
+        close(pipe_fds[1]);
+        pool_type pool(fd);
+        bool ok = pool.is_open();
+        uint64_t offset;
+        for(long seq = 0; ok && seq < messages; ++seq) {
+            ok = read(pipe_fds[0], &offset, sizeof(offset)) == sizeof(offset) &&
+                check(pool.at(offset), seq) && pool.deallocate(pool.at(offset)) == 0;
+        }
+        _exit(ok ? 0 : 1);
+    }
+    close(pipe_fds[0]);
+    pool_type pool(fd);
+    for(long seq = 0; seq < messages; ++seq) {
+        sample *s;
+        while((s = pool.allocate()) == nullptr) {
+            sched_yield();
+        }
+        fill(s, seq);
+        uint64_t offset = pool.offset_of(s);
+        assert( write(pipe_fds[1], &offset, sizeof(offset)) == sizeof(offset) );
+    }
+    close(pipe_fds[1]);
+    int status;
+    assert( waitpid(child, &status, 0) == child );
+    assert( WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+    assert( pool.available_count() == slots );
+}
+
+// Both processes allocate and free from the same free list at once.
+static void contend(int fd) {
+    pid_t child = fork();
+    assert( child >= 0 );
+    pool_type pool(fd);
+    bool ok = true;
+    for(int round = 0; round < 2000; ++round) {
+        sample *got[slots / 2];
+        size_t n = pool.allocate_n(got, slots / 2);
+        for(size_t i = 0; i < n; ++i) {
+            fill(got[i], child * 1000 + i);
+        }
+        for(size_t i = 0; i < n; ++i) {
+            ok = ok && check(got[i], child * 1000 + i);
+        }
+        ok = ok && pool.deallocate_n(got, n) == n;
+    }
+    if(child == 0) {
+        _exit(ok ? 0 : 1);
+    }
+    int status;
+    assert( waitpid(child, &status, 0) == child );
+    assert( ok && WIFEXITED(status) && WEXITSTATUS(status) == 0 );
+    assert( pool.available_count() == slots );
+}
+
+// A process that dies halfway through building the pool must not leave
+// the segment unusable: the next one to attach rebuilds it, whether the
+// builder was reaped already or is still a zombie.
+static void dead_builder(bool reap) {
+    int fd = memfd_create("test_shm_allocator.dead", 0);
+    assert( fd >= 0 && ftruncate(fd, 4096) == 0 );
+    pid_t child = fork();
+    assert( child >= 0 );
+    if(child == 0) {
+        // what attach() does before it builds: claim the state word, which
+        // leads the segment, with our pid
+        void *addr = mmap(nullptr, 4096, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        auto state = static_cast<atomic<uint32_t> *>(addr);
+        uint32_t blank = 0;
+        state->compare_exchange_strong(blank, uint32_t(getpid()));
+        raise(SIGKILL);
+    }
+    siginfo_t info;
+    assert( waitid(P_PID, child, &info, WEXITED | (reap ? 0 : WNOWAIT)) == 0 );
+    assert( info.si_code == CLD_KILLED );
+    {
+        pool_type pool(fd);
+        assert( pool.is_open() && pool.available_count() == slots );
+        sample *s = pool.allocate();
+        assert( s != nullptr && pool.deallocate(s) == 0 );
+    }
+    if(!reap) {
+        assert( waitpid(child, nullptr, 0) == child );
+    }
+    close(fd);
+}
+
+int main() {
+    int fd = memfd_create("test_shm_allocator", 0);
+    assert( fd >= 0 );
+    {
+        pool_type pool(fd);
+        assert( pool.is_open() );
+        sample *s = pool.allocate();
+        fill(s, 7);
+        // a second mapping sees the same pool at another address
+        pool_type other(fd);
+        assert( other.available_count() == slots - 1 );
+        sample *same = other.at(pool.offset_of(s));
+        assert( same != s && check(same, 7) );
+        assert( other.deallocate(same) == 0 );
+        assert( pool.available_count() == slots );
+    }
+    handoff(fd);
+    contend(fd);
+    {
+        // a pool of another shape must not map this segment
+        shm_allocator<sample, slots * 2> larger(fd);
+        assert( !larger.is_open() && larger.allocate() == nullptr );
+        shm_allocator<long, slots> other_type(fd);
+        assert( !other_type.is_open() );
+        pool_type same(fd);
+        assert( same.is_open() && same.available_count() == slots );
+    }
+    close(fd);
+    dead_builder(true);
+    dead_builder(false);
+
+    // named segments work the same way
+    char name[64];
+    snprintf(name, sizeof(name), "/test_shm_allocator.%d", int(getpid()));
+    {
+        pool_type a(name);
+        pool_type b(name);
+        assert( a.is_open() && b.is_open() );
+        sample *s = a.allocate();
+        assert( b.available_count() == slots - 1 );
+        assert( b.deallocate(b.at(a.offset_of(s))) == 0 );
+        assert( pool_type::remove(name) );
+    }
+    return 0;
+}
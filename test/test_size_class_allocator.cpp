@@ -0,0 +1,73 @@
+#include "allocator.h"
+#include "size_class_allocator.h"
+#include "cassert"
+#include "cstdint"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires array_allocator<Alloc> && extend_allocator<Alloc>
+void test(Alloc &allocator) {
+    char *a = allocator.allocate(10);
+    assert( allocator.has(a) == true );
+    allocator.deallocate(a, 10);
+    assert( allocator.stats(0).in_use == 0 );
+}
+
+int main() {
+    // 16, 32, 64 and 128 byte classes
+    size_class_allocator<char, 2, 2, 1, 1> allocator;
+    test(allocator);
+
+    static_assert( allocator.class_of(1) == 0 );
+    static_assert( allocator.class_of(16) == 0 );
+    static_assert( allocator.class_of(17) == 1 );
+    static_assert( allocator.class_of(128) == 3 );
+    static_assert( allocator.class_of(129) == 4 );
+
+    char *a = allocator.allocate(40);
+    assert( allocator.stats(2).in_use == 1 );
+    assert( allocator.available_count() == 5 );
+
+    // the 64 byte slab is full, so the next request spills to 128
+    char *b = allocator.allocate(40);
+    assert( b != nullptr );
+    assert( allocator.stats(2).spills == 1 );
+    assert( allocator.stats(3).in_use == 1 );
+    assert( allocator.allocate(40) == nullptr );
+    assert( allocator.stats(2).failures == 1 );
+    assert( allocator.stats(2).requests == 3 );
+
+    // too large for any class
+    assert( allocator.allocate(129) == nullptr );
+
+    allocator.deallocate(b, 40);
+    allocator.deallocate(a, 40);
+    assert( allocator.stats(2).in_use == 0 );
+    assert( allocator.stats(3).in_use == 0 );
+    assert( allocator.stats(2).peak == 1 );
+    assert( allocator.available_count() == 6 );
+
+    // a double free neither frees the block again nor skews the stats
+    a = allocator.allocate(40);
+    allocator.deallocate(a, 40);
+    allocator.deallocate(a, 40);
+    assert( allocator.stats(2).in_use == 0 );
+    assert( allocator.available_count() == 6 );
+    assert( allocator.allocate(40) == a );
+    assert( allocator.allocate(40) != a );
+    assert( allocator.stats(2).in_use == 1 && allocator.stats(3).in_use == 1 );
+
+    size_class_allocator<long, 4, 4> longs;
+    long *l = longs.allocate(3);
+    assert( longs.stats(1).in_use == 1 );
+    longs.deallocate(l, 3);
+
+    // counts whose byte size overflows fit no class
+    assert( longs.allocate(SIZE_MAX / sizeof(long) + 2) == nullptr );
+    assert( longs.allocate(SIZE_MAX) == nullptr );
+    l = longs.allocate(1);
+    longs.deallocate(l, SIZE_MAX / sizeof(long) + 2);
+    assert( longs.stats(0).in_use == 0 );
+    return 0;
+}
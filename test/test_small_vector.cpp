@@ -0,0 +1,67 @@
+#include "small_vector.h"
+#include "tlsf_allocator.h"
+#include "size_class_allocator.h"
+#include "cassert"
+#include "string"
+#include "utility"
+
+using namespace std;
+using namespace kcore;
+
+alignas(16) static unsigned char region[1 << 16];
+
+int main() {
+    tlsf_allocator<char> heap(region, sizeof(region));
+    size_t heap_free = heap.free_bytes();
+    {
+        small_vector<int, 4, decltype(heap)> v(heap);
+        for(int i = 0; i < 4; ++i) {
+            v.push_back(i);
+        }
+        assert( v.is_inline() && heap.free_bytes() == heap_free );
+
+        // the fifth element spills to the allocator
+        v.push_back(v[0]);
+        assert( !v.is_inline() && v.capacity() == 8 );
+        assert( v[4] == 0 && v[3] == 3 );
+        v.insert(v.begin(), 7);
+        v.erase(v.begin() + 1);
+        assert( v.size() == 5 && v[0] == 7 && v[1] == 1 );
+
+        // moves hand the buffer over without allocating
+        size_t before = heap.free_bytes();
+        small_vector<int, 4, decltype(heap)> moved(std::move(v));
+        assert( heap.free_bytes() == before );
+        assert( v.empty() && v.is_inline() && moved.size() == 5 );
+
+        small_vector<int, 4, decltype(heap)> copy(moved);
+        assert( copy.size() == 5 && copy[0] == 7 && copy.data() != moved.data() );
+        assert( copy.resize(2) && copy.size() == 2 );
+    }
+    assert( heap.free_bytes() == heap_free );
+
+    // non-trivial elements survive the spill and the move
+    {
+        small_vector<string, 2, decltype(heap)> s(heap);
+        s.push_back("a");
+        s.push_back(string(50, 'x'));
+        s.insert(s.begin() + 1, s[1]);
+        assert( !s.is_inline() );
+        assert( s[0] == "a" && s[1] == string(50, 'x') && s[2] == s[1] );
+        small_vector<string, 2, decltype(heap)> t(heap);
+        t.push_back("t");
+        t = std::move(s);
+        assert( t.size() == 3 && s.empty() );
+    }
+    assert( heap.free_bytes() == heap_free );
+
+    // running out of spill memory is reported, not thrown
+    size_class_allocator<char, 1, 1> tiny;
+    small_vector<long, 2, decltype(tiny)> w(tiny);
+    for(long i = 0; i < 4; ++i) {
+        assert( w.push_back(i) );
+    }
+    assert( !w.push_back(4) );
+    assert( w.size() == 4 && w[3] == 3 );
+    return 0;
+}
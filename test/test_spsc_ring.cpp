@@ -0,0 +1,167 @@
+#include "spsc_ring.h"
+#include "tlsf_allocator.h"
+#include "cassert"
+#include "new"
+#include "string"
+#include "thread"
+
+using namespace std;
+using namespace kcore;
+
+alignas(16) static unsigned char region[1 << 16];
+
+static int live = 0;
+
+struct tracked {
+    int value;
+    tracked(int v = 0) : value(v) { ++live; }
+    tracked(const tracked &o) : value(o.value) { ++live; }
+    auto operator=(const tracked &o) -> tracked & { value = o.value; return *this; }
+    ~tracked() { --live; }
+};
+
+// 1M sequence numbers from one thread to another, in batches of varying
+// size, must arrive complete and in order.
+template<class Ring>
+void handoff(Ring &ring) {
+    const size_t total = 1 << 20;
+    thread producer([&] {
+        size_t next = 0;
+        size_t batch[7];
+        while(next < total) {
+            size_t n = 1 + next % 7;
+            if(n > total - next) {
+                n = total - next;
+            }
+            for(size_t i = 0; i < n; ++i) {
+                batch[i] = next + i;
+            }
+            size_t pushed = ring.push_n(batch, n);
+            next += pushed;
+            if(pushed == 0) {
+                this_thread::yield();
+            }
+        }
+    });
+    size_t expect = 0;
+    size_t out[5];
+    while(expect < total) {
+        size_t n = ring.pop_n(out, 1 + expect % 5);
+        for(size_t i = 0; i < n; ++i) {
+            assert( out[i] == expect++ );
+        }
+        if(n == 0) {
+            this_thread::yield();
+        }
+    }
+    producer.join();
+    assert( ring.empty() );
+}
+
+int main() {
+    {
+        spsc_ring<int, 8> ring;
+        static_assert(spsc_ring<int, 8>::capacity() == 8, "");
+        assert( ring.valid() && ring.empty() );
+        int v;
+        assert( !ring.pop(v) );
+
+        // every slot is usable
+        for(int i = 0; i < 8; ++i) {
+            assert( ring.push(i) );
+        }
+        assert( !ring.push(8) && ring.size() == 8 );
+        assert( ring.pop(v) && v == 0 );
+        assert( ring.push(8) );
+
+        int out[16];
+        assert( ring.pop_n(out, 16) == 8 );
+        for(int i = 0; i < 8; ++i) {
+            assert( out[i] == i + 1 );
+        }
+
+        // head and tail now sit at 9: push_n wraps, pop_n follows
+        int in[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        assert( ring.push_n(in, 10) == 8 );
+        assert( ring.push_n(in, 1) == 0 );
+        assert( ring.pop_n(out, 3) == 3 && out[2] == 2 );
+
+        // reserve and peek stop at the end of the slot array
+        size_t n = 8;
+        int *w = ring.reserve(n);
+        assert( w != nullptr && n == 3 );
+        w[0] = 100;
+        w[1] = 101;
+        ring.commit(2);
+        n = 8;
+        int *r = ring.peek(n);
+        assert( r != nullptr && n == 4 && r[0] == 3 && r[3] == 6 );
+        ring.consume(4);
+        n = 8;
+        r = ring.peek(n);
+        assert( n == 3 && r[0] == 7 && r[1] == 100 && r[2] == 101 );
+        ring.consume(3);
+        n = 8;
+        w = ring.reserve(n);
+        assert( w != nullptr && n == 5 );
+        ring.commit(0);
+        n = 8;
+        assert( ring.peek(n) == nullptr && n == 0 );
+    }
+
+    // elements are constructed in the ring and destroyed when they leave
+    {
+        spsc_ring<tracked, 4> ring;
+        tracked t(5);
+        ring.push(t);
+        ring.emplace(6);
+        size_t n = 2;
+        tracked *w = ring.reserve(n);
+        assert( n == 2 );
+        new (w) tracked(7);
+        ring.commit(1);
+        assert( live == 4 );
+        tracked out;
+        assert( ring.pop(out) && out.value == 5 && live == 4 );
+        n = 1;
+        assert( ring.peek(n)->value == 6 );
+        ring.consume(1);
+        assert( live == 3 );
+    }
+    assert( live == 0 );
+
+    {
+        spsc_ring<string, 4> ring;
+        ring.push(string(40, 'a'));
+        ring.emplace(3, 'b');
+        string s;
+        assert( ring.pop(s) && s == string(40, 'a') );
+        // the remaining element is freed by the destructor
+    }
+
+    tlsf_allocator<char> heap(region, sizeof(region));
+    size_t heap_free = heap.free_bytes();
+    {
+        spsc_ring<size_t, 1024, decltype(heap)> ring(heap);
+        assert( ring.valid() && heap.free_bytes() < heap_free );
+        handoff(ring);
+    }
+    assert( heap.free_bytes() == heap_free );
+    {
+        // a ring the allocator could not serve refuses every call
+        spsc_ring<size_t, 1 << 14, decltype(heap)> too_big(heap);
+        assert( !too_big.valid() && too_big.empty() );
+        size_t v = 1;
+        assert( !too_big.push(v) && !too_big.emplace(v) );
+        assert( too_big.push_n(&v, 1) == 0 );
+        size_t n = 4;
+        assert( too_big.reserve(n) == nullptr && n == 0 );
+        assert( !too_big.pop(v) && too_big.pop_n(&v, 1) == 0 );
+        n = 4;
+        assert( too_big.peek(n) == nullptr && n == 0 );
+    }
+
+    static spsc_ring<size_t, 64> small;
+    handoff(small);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include "static_vector.h"
+#include "cassert"
+#include "string"
+#include "utility"
+
+using namespace std;
+using namespace kcore;
+
+template<class V>
+void check(const V &v, initializer_list<int> want) {
+    assert( v.size() == want.size() );
+    size_t i = 0;
+    for(int w : want) {
+        assert( v[i++] == w );
+    }
+}
+
+int main() {
+    // trivially copyable elements take the memmove paths
+    static_vector<int, 6> v;
+    assert( v.empty() && v.capacity() == 6 );
+    for(int i = 0; i < 4; ++i) {
+        assert( v.push_back(i) );
+    }
+    assert( *v.insert(v.begin() + 1, 9) == 9 );
+    check(v, {0, 9, 1, 2, 3});
+    assert( v.erase(v.begin()) == v.begin() );
+    check(v, {9, 1, 2, 3});
+    v.erase(v.begin() + 1, v.begin() + 3);
+    check(v, {9, 3});
+    v.insert(v.end(), v[0]);
+    check(v, {9, 3, 9});
+
+    // overflow is reported, never thrown, and leaves the vector intact
+    assert( v.resize(6) );
+    assert( v.full() );
+    assert( !v.push_back(1) );
+    assert( v.emplace_back(1) == nullptr );
+    assert( v.insert(v.begin(), 1) == nullptr );
+    assert( !v.resize(7) );
+    assert( v.size() == 6 && v[0] == 9 );
+
+    static_vector<int, 6> copy(v);
+    check(copy, {9, 3, 9, 0, 0, 0});
+    static_vector<int, 6> moved(std::move(copy));
+    assert( moved.size() == 6 && copy.empty() );
+
+    // and everything else goes through constructors
+    static_vector<string, 4> s;
+    s.push_back("b");
+    s.emplace_back(40, 'd');
+    s.insert(s.begin(), "a");
+    s.insert(s.begin() + 2, s[0]);
+    assert( s[0] == "a" && s[1] == "b" && s[2] == "a" && s[3] == string(40, 'd') );
+    s.erase(s.begin() + 1);
+    assert( s.size() == 3 && s[1] == "a" );
+    static_vector<string, 4> t(s);
+    static_vector<string, 4> u;
+    u = std::move(t);
+    assert( t.empty() && u.size() == 3 && u[2] == string(40, 'd') );
+    u.pop_back();
+    u.clear();
+    assert( u.empty() );
+    return 0;
+}
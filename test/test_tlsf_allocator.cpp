@@ -0,0 +1,81 @@
+#include "allocator.h"
+#include "tlsf_allocator.h"
+#include "cassert"
+#include "cstdlib"
+#include "cstring"
+
+using namespace std;
+using namespace kcore;
+
+template<class Alloc> requires array_allocator<Alloc>
+void test(Alloc &allocator) {
+    char *a = allocator.allocate(100);
+    assert( a != nullptr );
+    allocator.deallocate(a, 100);
+}
+
+alignas(16) static unsigned char region[1 << 16];
+
+int main() {
+    tlsf_allocator<char> allocator(region, sizeof(region));
+    size_t initial = allocator.free_bytes();
+    assert( initial == sizeof(region) - 32 );
+    test(allocator);
+    assert( allocator.free_bytes() == initial );
+    assert( allocator.fragmentation() == 0.0 );
+
+    // neighbours are merged as soon as they are freed, in any order
+    char *a = allocator.allocate(1000);
+    char *b = allocator.allocate(1000);
+    char *c = allocator.allocate(1000);
+    assert( a != nullptr && b != nullptr && c != nullptr );
+    assert( allocator.has(b) );
+    allocator.deallocate(a, 1000);
+    allocator.deallocate(c, 1000);
+    assert( allocator.fragmentation() > 0.0 );
+    allocator.deallocate(b, 1000);
+    assert( allocator.free_bytes() == initial );
+    assert( allocator.largest_free_block() == initial );
+
+    // a freed block is reused for a request of the same size
+    char *d = allocator.allocate(1000);
+    allocator.deallocate(d, 1000);
+    assert( allocator.allocate(1000) == d );
+    allocator.deallocate(d, 1000);
+
+    assert( allocator.allocate(sizeof(region)) == nullptr );
+
+    // random trace: contents of live blocks must never be overwritten
+    constexpr int slots = 64;
+    char *live[slots] = {};
+    size_t sizes[slots] = {};
+    srand(1);
+    for(int i = 0; i < 20000; ++i) {
+        int k = rand() % slots;
+        if(live[k] != nullptr) {
+            for(size_t j = 0; j < sizes[k]; ++j) {
+                assert( live[k][j] == char(k) );
+            }
+            allocator.deallocate(live[k], sizes[k]);
+            live[k] = nullptr;
+        } else {
+            sizes[k] = 1 + rand() % 2000;
+            live[k] = allocator.allocate(sizes[k]);
+            if(live[k] != nullptr) {
+                assert( reinterpret_cast<uintptr_t>(live[k]) % 16 == 0 );
+                memset(live[k], k, sizes[k]);
+            }
+        }
+    }
+    for(int k = 0; k < slots; ++k) {
+        allocator.deallocate(live[k], sizes[k]);
+    }
+    assert( allocator.free_bytes() == initial );
+    assert( allocator.fragmentation() == 0.0 );
+
+    // element counts whose byte size overflows are refused, not wrapped
+    tlsf_allocator<long> longs(region, sizeof(region));
+    assert( longs.allocate(SIZE_MAX / sizeof(long) + 2) == nullptr );
+    assert( longs.allocate(SIZE_MAX) == nullptr );
+    return 0;
+}
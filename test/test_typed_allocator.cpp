@@ -1,15 +1,134 @@
 #include "typed_allocator.h"
 #include "cassert"
+#include "climits"
+#include "cstdint"
 #include "iostream"
 
 using namespace std;
 using namespace kcore;
 
+// needs no startup code: zero-initialized in .bss
+static typed_allocator<long, 1024, lazy_init> lazy;
+static_assert( is_trivially_default_constructible<typed_allocator<long, 1024, lazy_init>>::value );
+static_assert( is_trivially_default_constructible<typed_allocator<long, 8, lazy_init, split_layout>>::value );
+
+struct alignas(128) wide {
+    long v[3];
+};
+
+// every layout hands out distinct, aligned slots and recycles them LIFO
+template<class Layout, class Tp>
+void layout_test(size_t stride) {
+    typed_allocator<Tp, 4, eager_init, Layout> pool;
+    Tp *a = pool.allocate();
+    Tp *b = pool.allocate();
+    assert( reinterpret_cast<uintptr_t>(a) % alignof(Tp) == 0 );
+    assert( reinterpret_cast<unsigned char *>(b) - reinterpret_cast<unsigned char *>(a) == ptrdiff_t(stride) );
+    assert( pool.deallocate(a) == 0 );
+    assert( pool.allocate() == a );
+    assert( pool.available_count() == 2 );
+    assert( pool.deallocate(b) == 0 && pool.deallocate(a) == 0 );
+    assert( pool.available_count() == 4 );
+}
+
 int main() {
     typed_allocator<int,8> allocator;
     int *a = allocator.allocate();
     assert( allocator.available_count() == 7 );
     assert( allocator.has(a) == true );
     assert( allocator.deallocate(a) == 0);
+
+    // exhaust the pool, then check slots come back in LIFO order
+    int *all[8];
+    for(int i = 0; i < 8; ++i) {
+        all[i] = allocator.allocate();
+        assert( all[i] != nullptr );
+    }
+    assert( allocator.available_count() == 0 );
+    assert( allocator.allocate() == nullptr );
+    assert( allocator.deallocate(all[3]) == 0 );
+    assert( allocator.deallocate(all[5]) == 0 );
+    assert( allocator.available_count() == 2 );
+    assert( allocator.allocate() == all[5] );
+    assert( allocator.allocate() == all[3] );
+
+    // double free and foreign pointers are refused and leave the free
+    // list untouched
+    assert( allocator.deallocate(all[0]) == 0 );
+    assert( allocator.deallocate(all[0]) == -1 );
+    assert( allocator.available_count() == 1 );
+    int outside;
+    assert( allocator.has(&outside) == false );
+    assert( allocator.deallocate(&outside) == -1 );
+
+    // shared slots go back only when the last reference is dropped
+    int *shared = allocator.allocate();
+    assert( allocator.retain(shared) == 2 );
+    assert( allocator.deallocate(shared) == 1 );
+    assert( allocator.available_count() == 0 );
+    bool disposed = false;
+    assert( allocator.release(shared, [&](int *) { disposed = true; }) == 0 );
+    assert( disposed && allocator.available_count() == 1 );
+    assert( allocator.retain(shared) == -1 );
+    assert( allocator.retain(&outside) == -1 );
+
+    // the default count saturates at its char limit
+    shared = allocator.allocate();
+    for(int i = 2; i <= CHAR_MAX; ++i) {
+        assert( allocator.retain(shared) == i );
+    }
+    assert( allocator.retain(shared) == -1 );
+    for(int i = CHAR_MAX - 1; i >= 0; --i) {
+        assert( allocator.deallocate(shared) == i );
+    }
+
+    // a wider Count goes well past a byte
+    typed_allocator<int,4,eager_init,packed_layout,uint16_t> counted;
+    shared = counted.allocate();
+    for(int i = 2; i <= UINT16_MAX; ++i) {
+        assert( counted.retain(shared) == i );
+    }
+    assert( counted.retain(shared) == -1 );
+    for(int i = UINT16_MAX - 1; i >= 0; --i) {
+        assert( counted.deallocate(shared) == i );
+    }
+
+    // batches come off the free list in one walk
+    typed_allocator<int,8> batch;
+    int *got[10];
+    assert( batch.allocate_n(got, 5) == 5 );
+    assert( batch.available_count() == 3 );
+    assert( batch.allocate_n(got + 5, 5) == 3 );
+    assert( batch.available_count() == 0 );
+    got[8] = &outside;
+    assert( batch.deallocate_n(got, 9) == 8 );
+    assert( batch.available_count() == 8 );
+    assert( batch.deallocate_n(got, 2) == 0 );
+
+    // a lazy pool hands out slots in address order until it wraps around
+    long *first = lazy.allocate();
+    assert( lazy.available_count() == 1023 );
+    assert( lazy.allocate() == first + 1 );
+    assert( lazy.deallocate(first) == 0 );
+    assert( lazy.allocate() == first );
+    long *rest[1022];
+    assert( lazy.allocate_n(rest, 1022) == 1022 );
+    assert( rest[0] == first + 2 );
+    assert( lazy.allocate() == nullptr );
+
+    // slots smaller than the free list link still work
+    typed_allocator<char,300> bytes;
+    char *c = bytes.allocate();
+    assert( bytes.has(c) == true );
+    assert( bytes.available_count() == 299 );
+    assert( bytes.deallocate(c) == 0 );
+    assert( bytes.available_count() == 300 );
+
+    layout_test<packed_layout, int>(sizeof(int));
+    layout_test<padded_layout, int>(KCORE_CACHE_LINE);
+    layout_test<split_layout, int>(sizeof(int));
+    layout_test<packed_layout, wide>(sizeof(wide));
+    layout_test<padded_layout, wide>(sizeof(wide));
+    layout_test<split_layout, wide>(sizeof(wide));
     return 0;
 }